@@ -0,0 +1,229 @@
+/*************************
+ * @file Benchmark.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Minimal benchmark harness writing machine readable results
+ *
+ * @date 2024-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include <ETCS/Detail/Core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef ETCS_VERSION
+#define ETCS_VERSION "unknown"
+#endif
+
+namespace etcs {
+
+namespace bench {
+
+// stops the compiler from optimizing away the results of a benchmark
+template <class Ty> inline void doNotOptimize(const Ty& value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const Ty* sink;
+	sink = &value;
+#endif
+}
+
+// distinct component types generated from an index
+template <std::size_t Index> struct Component {
+	float value = 1.0f;
+};
+
+// passed to every benchmark, only the time between start() and stop() is measured
+class State {
+public:
+	State(std::size_t size) : m_size(size), m_operations(size) { }
+
+	void start() {
+		m_begin = std::chrono::steady_clock::now();
+	}
+	void stop() {
+		m_elapsed += std::chrono::steady_clock::now() - m_begin;
+	}
+
+	void operations(std::size_t count) noexcept { // number of operations the elapsed time is divided by, defaults to the size
+		m_operations = count;
+	}
+	void counter(std::string_view name, double value) { // additional value reported alongside the timing
+		for (auto& [n, v] : m_counters) {
+			if (n == name) {
+				v = value;
+				return;
+			}
+		}
+
+		m_counters.emplace_back(name, value);
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return m_size;
+	}
+
+private:
+	std::size_t m_size;
+	std::size_t m_operations;
+
+	std::chrono::steady_clock::time_point m_begin { };
+	std::chrono::steady_clock::duration m_elapsed { };
+
+	std::vector<std::pair<std::string, double>> m_counters;
+
+	friend class Runner;
+};
+
+// parses the command line, runs the benchmarks and writes the results as json or csv
+class Runner {
+public:
+	Runner(int argc, char** argv) {
+		for (int i = 1; i < argc; i++) {
+			std::string_view arg = argv[i];
+			auto value = [&]() -> std::string_view {
+				if (i + 1 >= argc) {
+					std::cerr << "Missing value for " << arg << "!\n";
+					std::exit(EXIT_FAILURE);
+				}
+
+				return argv[++i];
+			};
+
+			if (arg == "--format") m_format = value();
+			else if (arg == "--output") m_output = value();
+			else if (arg == "--filter") m_filter = value();
+			else if (arg == "--min-size") m_minSize = std::strtoull(value().data(), nullptr, 10);
+			else if (arg == "--max-size") m_maxSize = std::strtoull(value().data(), nullptr, 10);
+			else if (arg == "--repetitions") m_repetitions = std::max<std::size_t>(std::strtoull(value().data(), nullptr, 10), 1);
+			else {
+				std::cerr <<
+					"Usage: " << argv[0] << " [options]\n"
+					"  --format json|csv      format of the results, json by default\n"
+					"  --output <file>        file to write the results to, stdout by default\n"
+					"  --filter <substring>   only run benchmarks whose name contains the substring\n"
+					"  --min-size <count>     smallest entity count to run\n"
+					"  --max-size <count>     largest entity count to run\n"
+					"  --repetitions <count>  repetitions of every benchmark and size\n";
+				std::exit((arg == "--help") ? EXIT_SUCCESS : EXIT_FAILURE);
+			}
+		}
+
+		if (m_format != "json" && m_format != "csv") {
+			std::cerr << "Unknown output format " << m_format << "!\n";
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+	template <class Function> void run(std::string_view name, const std::vector<std::size_t>& sizes, Function&& function) {
+		if (name.find(m_filter) == std::string_view::npos) return;
+
+		for (auto size : sizes) {
+			if (size < m_minSize || size > m_maxSize) continue;
+
+			Result result { std::string(name), size, 1, { }, { } };
+
+			for (std::size_t i = 0; i < m_repetitions; i++) {
+				State state(size);
+				function(state);
+
+				result.nanoseconds.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(state.m_elapsed).count()));
+				result.operations = std::max<std::size_t>(state.m_operations, 1);
+				result.counters = std::move(state.m_counters);
+			}
+
+			std::sort(result.nanoseconds.begin(), result.nanoseconds.end());
+			std::cerr << result.name << '/' << size << ": " << result.nanoseconds.front() / result.operations << " ns/op\n";
+
+			m_results.push_back(std::move(result));
+		}
+	}
+
+	void write() const {
+		std::ofstream file;
+		if (!m_output.empty()) file.open(std::string(m_output));
+
+		std::ostream& out = m_output.empty() ? std::cout : file;
+		if (!out) {
+			std::cerr << "Failed to open " << m_output << "!\n";
+			std::exit(EXIT_FAILURE);
+		}
+
+		if (m_format == "json") writeJson(out);
+		else writeCsv(out);
+	}
+
+private:
+	struct Result {
+		std::string name;
+		std::size_t size;
+		std::size_t operations = 1;
+
+		std::vector<double> nanoseconds;
+		std::vector<std::pair<std::string, double>> counters;
+
+		[[nodiscard]] double min() const {
+			return nanoseconds.front() / operations;
+		}
+		[[nodiscard]] double median() const {
+			return nanoseconds[nanoseconds.size() / 2] / operations;
+		}
+	};
+
+	std::vector<Result> m_results;
+
+	std::string_view m_format = "json";
+	std::string_view m_output;
+	std::string_view m_filter;
+
+	std::size_t m_minSize = 0;
+	std::size_t m_maxSize = std::numeric_limits<std::size_t>::max();
+	std::size_t m_repetitions = 3;
+
+	void writeJson(std::ostream& out) const {
+		out << "{\n\t\"version\": \"" ETCS_VERSION "\",\n\t\"repetitions\": " << m_repetitions << ",\n\t\"results\": [\n";
+
+		for (std::size_t i = 0; i < m_results.size(); i++) {
+			const auto& r = m_results[i];
+
+			out << "\t\t{ \"name\": \"" << r.name << "\", \"size\": " << r.size << ", \"operations\": " << r.operations <<
+				", \"ns_per_op_min\": " << r.min() << ", \"ns_per_op_median\": " << r.median();
+			for (const auto& [name, value] : r.counters) out << ", \"" << name << "\": " << value;
+
+			out << ((i + 1 < m_results.size()) ? " },\n" : " }\n");
+		}
+
+		out << "\t]\n}\n";
+	}
+
+	void writeCsv(std::ostream& out) const { // counters are flattened into name=value pairs so every row has the same columns
+		out << "version,name,size,operations,ns_per_op_min,ns_per_op_median,counters\n";
+
+		for (const auto& r : m_results) {
+			out << ETCS_VERSION "," << r.name << ',' << r.size << ',' << r.operations << ',' << r.min() << ',' << r.median() << ',';
+
+			for (std::size_t i = 0; i < r.counters.size(); i++) out << ((i > 0) ? ";" : "") << r.counters[i].first << '=' << r.counters[i].second;
+			out << '\n';
+		}
+	}
+};
+
+} // namespace bench
+
+} // namespace etcs
@@ -0,0 +1,141 @@
+#include "Benchmark.h"
+
+#include <ETCS/ETCS.h>
+
+#include <array>
+#include <bitset>
+#include <random>
+#include <unordered_set>
+#include <utility>
+
+using namespace etcs;
+using namespace etcs::bench;
+
+namespace {
+
+constexpr std::size_t maxTypes = 256;
+constexpr std::size_t entitiesPerArchetype = 8;
+constexpr std::size_t queryConstructions = 1000;
+constexpr std::size_t migrationSamples = 1024;
+
+const std::vector<std::size_t> archetypeCounts = { 10, 100, 1'000, 10'000, 100'000 };
+const std::size_t typeCounts[] = { 64, 128, 256 };
+
+using Combination = std::bitset<maxTypes>;
+using Migrated = Component<maxTypes>; // never part of a generated combination, used to measure archetype migration
+
+// components are chosen at runtime, so insertion is dispatched through a table with one function per type
+template <std::size_t... Indices> consteval auto insertTable(std::index_sequence<Indices...>) {
+	return std::array<void (*)(Prefab&), sizeof...(Indices)> {
+		[](Prefab& prefab) { prefab.insertComponent<Component<Indices>>(); }...
+	};
+}
+
+constexpr auto insertComponent = insertTable(std::make_index_sequence<maxTypes>());
+
+// generates distinct random combinations of 2 to 12 components out of the given number of types
+std::vector<Combination> combinations(std::size_t count, std::size_t types, std::mt19937_64& random) {
+	std::uniform_int_distribution<std::size_t> typeDistribution(0, types - 1);
+	std::uniform_int_distribution<std::size_t> sizeDistribution(2, 12);
+
+	std::unordered_set<Combination> unique;
+	std::vector<Combination> result;
+	result.reserve(count);
+
+	while (result.size() < count) {
+		Combination combination;
+
+		for (auto size = sizeDistribution(random); combination.count() < size;) combination.set(typeDistribution(random));
+		if (unique.insert(combination).second) result.push_back(combination);
+	}
+
+	return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	Runner runner(argc, argv);
+
+	init();
+
+	for (auto types : typeCounts) {
+		// the timing is the construction of a query, the other measurements of the same world are reported as counters
+		runner.run("fragmentation/types_" + std::to_string(types), archetypeCounts, [types](State& state) {
+			std::mt19937_64 random(state.size() * maxTypes + types);
+			auto generated = combinations(state.size(), types, random);
+
+			auto world = insertWorld("benchmark_world");
+
+			std::vector<Entity> entities;
+			entities.reserve(generated.size() * entitiesPerArchetype);
+
+			for (const auto& combination : generated) { // instantiating a prefab creates exactly one archetype per combination
+				Prefab prefab("benchmark_prefab_entity");
+				for (std::size_t i = 0; i < types; i++) if (combination.test(i)) insertComponent[i](prefab);
+
+				for (auto& entity : world.instantiate(prefab, entitiesPerArchetype)) entities.push_back(entity);
+			}
+
+			auto memory = world.memoryStats();
+
+
+			// query construction, the archetypes matched by two common component types have to be intersected
+
+			state.operations(queryConstructions);
+
+			state.start();
+			for (std::size_t i = 0; i < queryConstructions; i++) doNotOptimize(world.query<Component<0>, Component<1>>());
+			state.stop();
+
+
+			// iteration cost per matched entity
+
+			std::size_t matched = 0;
+			float sum = 0;
+
+			auto iterationBegin = std::chrono::steady_clock::now();
+			for (auto [component] : world.query<Component<0>>()) {
+				sum += component.value;
+				matched++;
+			}
+			auto iteration = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - iterationBegin).count();
+
+			doNotOptimize(sum);
+
+
+			// migration between archetypes, every sampled entity moves into a superset and back
+
+			auto samples = std::min(migrationSamples, entities.size());
+			auto step = entities.size() / samples;
+
+			auto migrationBegin = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < samples; i++) entities[i * step].insertComponent<Migrated>();
+			auto insertion = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - migrationBegin).count();
+
+			migrationBegin = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < samples; i++) entities[i * step].erase<Migrated>();
+			auto erasure = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - migrationBegin).count();
+
+
+			state.counter("component_types", static_cast<double>(types));
+			state.counter("entities", static_cast<double>(entities.size()));
+			state.counter("iteration_ns_per_entity", (matched > 0) ? iteration / matched : 0.0);
+			state.counter("iterated_entities", static_cast<double>(matched));
+			state.counter("migration_insert_ns", insertion / samples);
+			state.counter("migration_erase_ns", erasure / samples);
+			state.counter("world_bytes", static_cast<double>(memory.totalBytes()));
+			state.counter("world_bytes_per_archetype", static_cast<double>(memory.totalBytes()) / state.size());
+			state.counter("column_used_bytes", static_cast<double>(memory.usedBytes));
+			state.counter("archetype_reserved_bytes", static_cast<double>(memory.reservedBytes));
+			state.counter("archetype_bucket_bytes", static_cast<double>(memory.bucketBytes));
+			state.counter("archetype_table_bytes", static_cast<double>(memory.archetypeTableBytes));
+
+			world.destroy();
+		});
+	}
+
+	quit();
+
+	runner.write();
+}
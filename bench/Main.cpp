@@ -0,0 +1,245 @@
+#include "Benchmark.h"
+
+#include <ETCS/ETCS.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <utility>
+
+using namespace etcs;
+using namespace etcs::bench;
+
+namespace {
+
+const std::vector<std::size_t> sizes = { 1'000, 10'000, 100'000, 1'000'000, 10'000'000 };
+
+constexpr const char* childNames[] = { "child0", "child1", "child2", "child3", "child4", "child5", "child6", "child7" };
+constexpr std::size_t branching = std::size(childNames);
+
+template <std::size_t... Indices> Prefab componentPrefab(std::index_sequence<Indices...>) {
+	Prefab prefab("benchmark_prefab_entity");
+	(prefab.insertComponent<Component<Indices>>(), ...);
+
+	return prefab;
+}
+
+// builds a tree with the given entity count, every node has branching children, returns the nodes in breadth first order
+std::vector<Entity> insertTree(World world, std::size_t size) {
+	std::vector<Entity> nodes;
+	nodes.reserve(size);
+	nodes.push_back(world.insertEntity("benchmark_root_entity"));
+
+	for (std::size_t parent = 0; nodes.size() < size; parent++)
+		for (std::size_t i = 0; i < branching && nodes.size() < size; i++) nodes.push_back(nodes[parent].insertChild(childNames[i]));
+
+	return nodes;
+}
+
+std::size_t traverse(Entity& entity) {
+	std::size_t count = 1;
+	for (const auto& view : entity) {
+		Entity child(view, entity);
+		count += traverse(child);
+	}
+
+	return count;
+}
+
+template <std::size_t... Indices> void queryIteration(Runner& runner, std::index_sequence<Indices...>) {
+	auto name = std::string("query/iterate_") + std::to_string(sizeof...(Indices));
+
+	runner.run(name, sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		world.instantiate(componentPrefab(std::make_index_sequence<8>()), state.size()); // every entity has all components, so only column access differs
+
+		float sum = 0;
+
+		state.start();
+		for (auto components : world.query<Component<Indices>...>())
+			std::apply([&sum](auto&... component) { sum += (component.value + ...); }, components);
+		state.stop();
+
+		doNotOptimize(sum);
+		world.destroy();
+	});
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	Runner runner(argc, argv);
+
+	init();
+
+
+	// entities
+
+	runner.run("entity/insert", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+
+		state.start();
+		for (std::size_t i = 0; i < state.size(); i++) doNotOptimize(world.insertEntity());
+		state.stop();
+
+		world.destroy();
+	});
+
+	runner.run("entity/destroy", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+
+		std::vector<Entity> entities;
+		entities.reserve(state.size());
+		for (std::size_t i = 0; i < state.size(); i++) entities.push_back(world.insertEntity());
+
+		state.start();
+		for (auto& entity : entities) entity.destroy();
+		state.stop();
+
+		world.destroy();
+	});
+
+
+	// components
+
+	runner.run("component/insert_1", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		auto entities = world.instantiate(Prefab("benchmark_prefab_entity"), state.size());
+
+		state.start();
+		for (const auto& entity : entities) entity.insertComponent<Component<0>>();
+		state.stop();
+
+		world.destroy();
+	});
+
+	runner.run("component/insert_4", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		auto entities = world.instantiate(Prefab("benchmark_prefab_entity"), state.size());
+
+		state.start();
+		for (const auto& entity : entities) {
+			entity.insertComponent<Component<0>>();
+			entity.insertComponent<Component<1>>();
+			entity.insertComponent<Component<2>>();
+			entity.insertComponent<Component<3>>();
+		}
+		state.stop();
+
+		world.destroy();
+	});
+
+	runner.run("component/erase_1", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		auto entities = world.instantiate(componentPrefab(std::make_index_sequence<2>()), state.size());
+
+		state.start();
+		for (auto& entity : entities) entity.erase<Component<0>>();
+		state.stop();
+
+		world.destroy();
+	});
+
+	runner.run("component/erase_4", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		auto entities = world.instantiate(componentPrefab(std::make_index_sequence<4>()), state.size());
+
+		state.start();
+		for (auto& entity : entities) entity.erase<Component<0>>().erase<Component<1>>().erase<Component<2>>().erase<Component<3>>();
+		state.stop();
+
+		world.destroy();
+	});
+
+	runner.run("component/view_get_random", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		auto entities = world.instantiate(componentPrefab(std::make_index_sequence<1>()), state.size());
+
+		std::vector<ComponentView<Component<0>>> views;
+		views.reserve(entities.size());
+		for (const auto& entity : entities) views.push_back(entity.component<Component<0>>());
+
+		std::shuffle(views.begin(), views.end(), std::mt19937_64(state.size()));
+
+		float sum = 0;
+
+		state.start();
+		for (auto& view : views) sum += view.get().value;
+		state.stop();
+
+		doNotOptimize(sum);
+		world.destroy();
+	});
+
+
+	// queries
+
+	queryIteration(runner, std::make_index_sequence<1>());
+	queryIteration(runner, std::make_index_sequence<4>());
+	queryIteration(runner, std::make_index_sequence<8>());
+
+
+	// hierarchy
+
+	runner.run("hierarchy/traverse", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		auto root = insertTree(world, state.size()).front();
+
+		state.start();
+		doNotOptimize(traverse(root));
+		state.stop();
+
+		world.destroy();
+	});
+
+	runner.run("hierarchy/path_lookup", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		auto nodes = insertTree(world, state.size());
+
+		// paths to a fixed sample of the deepest nodes, looked up repeatedly until every entity was visited once on average
+		std::vector<std::string> paths;
+
+		auto step = std::max<std::size_t>(nodes.size() / 1024, 1);
+		for (std::size_t offset = 0; offset + 1 < nodes.size() && paths.size() < 1024; offset += step) {
+			std::string path;
+
+			for (auto i = nodes.size() - 1 - offset; i > 0; i = (i - 1) / branching) { // nodes are stored breadth first
+				if (!path.empty()) path.insert(0, "::");
+				path.insert(0, childNames[(i - 1) % branching]);
+			}
+
+			paths.push_back(std::move(path));
+		}
+
+		auto root = nodes.front();
+
+		state.start();
+		for (std::size_t i = 0; i < state.size(); i++) {
+			const auto& path = paths[i % paths.size()];
+			doNotOptimize(root.at(string_view_t(path.data(), path.size())));
+		}
+		state.stop();
+
+		world.destroy();
+	});
+
+#ifdef USE_COMPONENTS_EXT
+
+	runner.run("transform/propagate", sizes, [](State& state) {
+		auto world = insertWorld("benchmark_world");
+		for (auto& node : insertTree(world, state.size())) node.insertComponent<Transform>(glm::vec3(1.0f));
+
+		state.start();
+		for (auto [entity, transform] : world.query<Entity, Transform>()) doNotOptimize(transform.globalTransform(entity));
+		state.stop();
+
+		world.destroy();
+	});
+
+#endif
+
+	quit();
+
+	runner.write();
+}
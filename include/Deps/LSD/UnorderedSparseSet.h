@@ -18,6 +18,7 @@
 #include <vector>
 #include <forward_list>
 #include <initializer_list>
+#include <memory>
 #include <functional>
 #include <utility>
 
@@ -45,12 +46,12 @@ public:
 	using rvreference = value_type&&;
 	using pointer = value_type*;
 	using const_pointer = const pointer;
-	using array = std::vector<value_type>;
+	using array = std::vector<value_type, allocator_type>;
 
 	using bucket_type = size_type;
 	using bucket_pointer = bucket_type*;
-	using bucket_list = std::forward_list<bucket_type>;
-	using buckets = std::vector<bucket_list>;
+	using bucket_list = std::forward_list<bucket_type, typename std::allocator_traits<allocator_type>::template rebind_alloc<bucket_type>>; // nodes come from the allocator as well
+	using buckets = std::vector<bucket_list, typename std::allocator_traits<allocator_type>::template rebind_alloc<bucket_list>>;
 
 	using iterator = typename array::iterator;
 	using const_iterator = typename array::const_iterator;
@@ -71,15 +72,15 @@ public:
 		const key_equal& keyEqual = key_equal(), 
 		const allocator_type& alloc = allocator_type()) noexcept : 
 		m_array(alloc),
-		m_buckets(detail::hashmapBucketSizeCheck(bucketCount, 2)), 
+		m_buckets(detail::hashmapBucketSizeCheck(bucketCount, 2), alloc), 
 		m_hasher(hash), 
 		m_equal(keyEqual) { } 
 	constexpr UnorderedSparseSet(size_type bucketCount, const allocator_type& alloc) noexcept : 
-		m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, 2)) { } 
+		m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, 2), alloc) { } 
 	constexpr UnorderedSparseSet(size_type bucketCount, const hasher& hasher, const allocator_type& alloc) noexcept : 
-		m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, 2)), m_hasher(hasher) { } 
+		m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, 2), alloc), m_hasher(hasher) { } 
 	explicit constexpr UnorderedSparseSet(const allocator_type& alloc) noexcept : 
-		m_array(alloc), m_buckets(2) { } 
+		m_array(alloc), m_buckets(2, alloc) { } 
 	template <class It> constexpr UnorderedSparseSet(
 		It first, It last, 
 		size_type bucketCount = 0, // set to 0 for default evaluation
@@ -87,14 +88,14 @@ public:
 		const key_equal& keyEqual = key_equal(), 
 		const allocator_type& alloc = allocator_type()) noexcept requires isIteratorValue<It> : 
 		m_array(alloc),
-		m_buckets(detail::hashmapBucketSizeCheck(bucketCount, last - first)), 
+		m_buckets(detail::hashmapBucketSizeCheck(bucketCount, last - first), alloc), 
 		m_hasher(hash), 
 		m_equal(keyEqual) {
 		insert(first, last);
 	}
 	template <class It> constexpr UnorderedSparseSet(
 		It first, It last, size_type bucketCount, const allocator_type& alloc) noexcept 
-		requires isIteratorValue<It> : m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, last - first)) {
+		requires isIteratorValue<It> : m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, last - first), alloc) {
 		insert(first, last);
 	}
 	template <class It> constexpr UnorderedSparseSet(
@@ -103,18 +104,18 @@ public:
 		const hasher& hasher,
 		const allocator_type& alloc) noexcept requires isIteratorValue<It> : 
 		m_array(alloc),
-		m_buckets(detail::hashmapBucketSizeCheck(bucketCount, last - first)), 
+		m_buckets(detail::hashmapBucketSizeCheck(bucketCount, last - first), alloc), 
 		m_hasher(hasher) {
 		insert(first, last);
 	}
 	constexpr UnorderedSparseSet(const_container_reference other) : 
 		m_array(other.m_array), m_buckets(other.m_buckets) { }
 	constexpr UnorderedSparseSet(const_container_reference other, const allocator_type& alloc) :
-		m_array(other.m_array, alloc), m_buckets(other.m_buckets) { }
+		m_array(other.m_array, alloc), m_buckets(other.m_buckets, alloc) { }
 	constexpr UnorderedSparseSet(container_rvreference other) noexcept :
 		m_array(std::move(other.m_array)), m_buckets(std::move(other.m_buckets)) { }
 	constexpr UnorderedSparseSet(container_rvreference other, const allocator_type& alloc) : 
-		m_array(std::move(other.m_array), alloc), m_buckets(std::move(other.m_buckets)) { }
+		m_array(std::move(other.m_array), alloc), m_buckets(std::move(other.m_buckets), alloc) { }
 	constexpr UnorderedSparseSet(
 		std::initializer_list<value_type> ilist, 
 		size_type bucketCount = 0, // set to 0 for default evaluation
@@ -122,18 +123,18 @@ public:
 		const key_equal& keyEqual = key_equal(), 
 		const allocator_type& alloc = allocator_type()) noexcept : 
 		m_array(alloc),
-		m_buckets(detail::hashmapBucketSizeCheck(bucketCount, ilist.size())), 
+		m_buckets(detail::hashmapBucketSizeCheck(bucketCount, ilist.size()), alloc), 
 		m_hasher(hash), 
 		m_equal(keyEqual) {
 		insert(ilist.begin(), ilist.end());
 	} 
 	constexpr UnorderedSparseSet(std::initializer_list<value_type> ilist, size_type bucketCount, const allocator_type& alloc) noexcept : 
-		m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, ilist.size())) {
+		m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, ilist.size()), alloc) {
 		insert(ilist.begin(), ilist.end());
 	} 
 	constexpr UnorderedSparseSet(
 		std::initializer_list<value_type> ilist, size_type bucketCount, const hasher& hasher, const allocator_type& alloc) noexcept : 
-		m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, ilist.size())), m_hasher(hasher) {
+		m_array(alloc), m_buckets(detail::hashmapBucketSizeCheck(bucketCount, ilist.size()), alloc), m_hasher(hasher) {
 		insert(ilist.begin(), ilist.end());
 	}
 	constexpr ~UnorderedSparseSet() = default;
@@ -413,10 +414,10 @@ public:
 		return m_array.empty();
 	}
 	[[nodiscard]] constexpr allocator_type allocator() const noexcept {
-		return m_array.allocator();
+		return m_array.get_allocator();
 	}
 	[[deprecated]] [[nodiscard]] constexpr allocator_type get_allocator() const noexcept {
-		return m_array.allocator();
+		return m_array.get_allocator();
 	}
 
 	[[nodiscard]] constexpr size_type bucketCount() const noexcept {
@@ -18,11 +18,13 @@
 
 namespace etcs {
 
+struct Disabled { }; // tag of entities disabled through Entity::disable(), queries skip them and all of their descendants unless they contain the tag themselves, toggling it is a structural change
+
 template <class Ty> class ComponentView {
 public:
 	using value_type = Ty;
 	using const_value = const Ty;
-	using reference = value_type&;
+	using reference = std::conditional_t<detail::isShared<Ty>, const_value&, value_type&>; // shared values are immutable
 	using const_reference = const_value&;
 
 	constexpr ComponentView() = default;
@@ -33,10 +35,22 @@ public:
 	constexpr ComponentView& operator=(ComponentView&&) = default;
 
 	[[nodiscard]] reference get() {
-		return m_entities->archetype(m_id, m_index)->template component<value_type>(m_id);
+		if constexpr (detail::isSparse<value_type>) {
+			auto& pool = m_entities->sparse().template pool<value_type>();
+			if (!pool.contains(m_id)) throw std::out_of_range("etcs::ComponentView::get(): Entity does not contain the sparse component!");
+
+			return pool.get(m_id);
+		} else if constexpr (detail::isShared<value_type>) return m_entities->archetype(m_id, m_index)->template sharedComponent<value_type>();
+		else return m_entities->archetype(m_id, m_index)->template component<value_type>(m_id);
 	}
 	[[nodiscard]] const_reference get() const {
-		return m_entities->archetype(m_id, m_index)->template component<value_type>(m_id);
+		if constexpr (detail::isSparse<value_type>) {
+			auto pool = std::as_const(*m_entities).sparse().template find<value_type>();
+			if (!pool || !pool->contains(m_id)) throw std::out_of_range("etcs::ComponentView::get(): Entity does not contain the sparse component!");
+
+			return pool->get(m_id);
+		} else if constexpr (detail::isShared<value_type>) return m_entities->archetype(m_id, m_index)->template sharedComponent<value_type>();
+		else return m_entities->archetype(m_id, m_index)->template component<value_type>(m_id);
 	}
 
 	[[nodiscard]] object_id entityId() const {
@@ -48,7 +62,7 @@ public:
 
 private:
 	object_id m_id { };
-	std::size_t m_index { };
+	mutable std::size_t m_index { };
 
 	detail::EntityManager* m_entities { };
 
@@ -0,0 +1,52 @@
+/*************************
+ * @file ComponentTraits.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Per component type storage policies
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Detail/Core.h"
+
+#include <type_traits>
+
+namespace etcs {
+
+enum class ComponentStorage {
+	column, // one row per entity in a column of its archetype
+	tag, // only part of the signature of the archetype, without any memory or per entity work, only for empty types
+	sparse, // in a sparse set pool outside of the archetypes, inserting and erasing never moves the entity into another archetype
+	shared // one deduplicated immutable value per archetype, entities with equal values are grouped into the same archetype, values without entities are destroyed with their archetypes at the next World::nextFrame()
+};
+
+// specialize to choose the storage of a component type, empty types are tags by default
+template <class Ty> struct ComponentTraits {
+	static constexpr auto storage = std::is_empty_v<Ty> ? ComponentStorage::tag : ComponentStorage::column;
+};
+
+template <class Ty> inline constexpr auto componentStorage = ComponentTraits<std::remove_const_t<Ty>>::storage;
+
+namespace detail {
+
+template <class Ty> inline constexpr bool isTag = (componentStorage<Ty> == ComponentStorage::tag);
+template <class Ty> inline constexpr bool isSparse = (componentStorage<Ty> == ComponentStorage::sparse);
+template <class Ty> inline constexpr bool isShared = (componentStorage<Ty> == ComponentStorage::shared);
+
+template <class Ty> class TagInstance { // tags don't hold any state, so all of them share a single instance
+public:
+	static_assert(std::is_empty_v<Ty>, "etcs::detail::TagInstance: Only empty types can be stored as tags!");
+
+	static Ty& get() noexcept {
+		static Ty instance;
+		return instance;
+	}
+};
+
+} // namespace detail
+
+} // namespace etcs
@@ -0,0 +1,149 @@
+/*************************
+ * @file AccessGuard.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Reader writer lock of a world and detection of conflicting accesses
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Core.h"
+
+#include <algorithm>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+#include <atomic>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace etcs {
+
+namespace detail {
+
+template <class Ty> constexpr std::string_view typeName() noexcept { // readable name of a type for reports, parsed from the signature of this function
+#if defined(_MSC_VER) && !defined(__clang__)
+	std::string_view signature = __FUNCSIG__;
+	auto begin = signature.find("typeName<") + 9;
+	auto end = signature.rfind(">(void)");
+#else
+	std::string_view signature = __PRETTY_FUNCTION__;
+	auto begin = signature.find("Ty = ") + 5;
+	auto end = signature.find_first_of(";]", begin);
+#endif
+	return signature.substr(begin, end - begin);
+}
+
+struct ComponentAccess {
+	lsd::type_id typeId { };
+	std::string_view name;
+	bool writable = false;
+};
+
+template <class Ty> constexpr ComponentAccess componentAccess() noexcept {
+	return ComponentAccess { lsd::typeId<std::remove_const_t<Ty>>(), typeName<std::remove_const_t<Ty>>(), !std::is_const_v<Ty> };
+}
+
+struct AccessReader { // state of a single read access, only tracked with ETCS_ENABLE_ACCESS_CHECKS
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+	vector_t<ComponentAccess> components; // of all queries constructed under the read access
+	std::thread::id thread;
+#endif
+};
+
+// any number of read accesses or a single write access to a world at a time
+// with ETCS_ENABLE_ACCESS_CHECKS, structural changes and writable queries are also checked against the active read accesses, even if they don't hold write access
+class AccessGuard {
+public:
+	AccessGuard() = default;
+	AccessGuard(const AccessGuard&) = delete;
+
+	AccessGuard& operator=(const AccessGuard&) = delete;
+
+	void lockRead(AccessReader& reader, const char* operation = "etcs::ReadAccess::ReadAccess");
+	void unlockRead(AccessReader& reader) noexcept;
+	void lockWrite();
+	void unlockWrite() noexcept;
+
+	void insertReads(AccessReader& reader, span_t<const ComponentAccess> components) { // of a query constructed under read access
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+		std::lock_guard lock(m_readerMutex);
+
+		for (const auto& component : components)
+			if (std::none_of(reader.components.begin(), reader.components.end(), [&component](const auto& read) { return read.typeId == component.typeId; }))
+				reader.components.push_back(component);
+#else
+		(void)reader;
+		(void)components;
+#endif
+	}
+
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+	void beginWrite(const char* operation, const ComponentAccess* component = nullptr); // throws if any read access is active
+	void endWrite() noexcept {
+		m_writers.fetch_sub(1, std::memory_order_release);
+	}
+	void checkQuery(span_t<const ComponentAccess> components) const; // throws if a writable component of the query is read by an active read access
+
+	class WriteScope { // of a structural change
+	public:
+		WriteScope(AccessGuard& guard, const char* operation) : m_guard(guard) {
+			m_guard.beginWrite(operation);
+		}
+		WriteScope(AccessGuard& guard, const char* operation, const ComponentAccess& component) : m_guard(guard) {
+			m_guard.beginWrite(operation, &component);
+		}
+		WriteScope(const WriteScope&) = delete;
+		~WriteScope() {
+			m_guard.endWrite();
+		}
+
+		WriteScope& operator=(const WriteScope&) = delete;
+
+	private:
+		AccessGuard& m_guard;
+	};
+#endif
+
+private:
+	std::shared_mutex m_mutex;
+
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+	mutable std::mutex m_readerMutex; // only guards the list of readers, not the world
+	vector_t<AccessReader*> m_readers;
+	std::atomic<std::size_t> m_readerCount = 0; // so writes only lock if there are any readers
+
+	std::atomic<std::size_t> m_writers = 0; // structural changes in progress, nested ones are counted too
+	std::atomic<const char*> m_writeOperation = nullptr;
+
+	// the reader mutex has to be locked for both
+	[[nodiscard]] bool read(lsd::type_id typeId) const noexcept;
+	[[nodiscard]] std::string readNames() const; // of all components read by any active reader
+#endif
+};
+
+} // namespace detail
+
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+
+#define ETCS_ACCESS_CONCAT_IMPL(first, second) first##second
+#define ETCS_ACCESS_CONCAT(first, second) ETCS_ACCESS_CONCAT_IMPL(first, second)
+
+#define ETCS_WRITE_SCOPE(guard, operation) ::etcs::detail::AccessGuard::WriteScope ETCS_ACCESS_CONCAT(etcsWriteScope, __LINE__)(guard, operation)
+#define ETCS_COMPONENT_WRITE_SCOPE(guard, operation, type) ::etcs::detail::AccessGuard::WriteScope ETCS_ACCESS_CONCAT(etcsWriteScope, __LINE__)(guard, operation, ::etcs::detail::componentAccess<type>())
+
+#else
+
+#define ETCS_WRITE_SCOPE(guard, operation) ((void)0)
+#define ETCS_COMPONENT_WRITE_SCOPE(guard, operation, type) ((void)0)
+
+#endif
+
+} // namespace etcs
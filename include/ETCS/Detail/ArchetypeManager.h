@@ -16,16 +16,39 @@
 #include <LSD/UnorderedSparseSet.h>
 
 #include "Core.h"
+#include "CopyOnWrite.h"
+#include "SharedStorage.h"
+#include "WorldMemory.h"
+
+#include "../ComponentTraits.h"
+#include "../MemoryStats.h"
+#include "../Profiler.h"
 
 namespace etcs {
 
 namespace detail {
 
+enum class SignaturePart {
+	none,
+	component,
+	tag,
+	shared,
+	relation
+};
+
+// a single change to the signature of an archetype, hashes only narrow down the candidates, which are then compared against the changed signature
+struct SignatureEdit {
+	SignaturePart part = SignaturePart::none;
+	lsd::type_id typeId = { };
+	bool erase = false;
+	std::size_t value = 0; // handle of a shared value or target of a relation
+};
+
 class Archetype {
 private:
 	class ComponentAllocator {
 	private:
-		class BasicMemory {
+		class BasicMemory : public CowShared {
 		public:
 			virtual ~BasicMemory() { }
 
@@ -33,6 +56,8 @@ private:
 
 			virtual void* emplaceBack(void*) = 0;
 			virtual void eraseComponent(std::size_t) = 0;
+			virtual void eraseComponents(const pmr_vector_t<std::size_t>&) = 0;
+			virtual void clear() = 0;
 
 			virtual void* componentData(std::size_t) = 0;
 			virtual const void* componentData(std::size_t) const = 0;
@@ -41,13 +66,27 @@ private:
 			virtual const void* begin() const = 0;
 
 			virtual std::size_t count() const noexcept = 0;
+			virtual std::size_t capacity() const noexcept = 0;
+			virtual std::size_t elementSize() const noexcept = 0;
+
+			virtual void copyBack(const void*, std::size_t) = 0;
+			virtual void moveBack(BasicMemory&) = 0;
 
-			virtual unique_ptr_t<BasicMemory> copyType() const = 0;
+			virtual shared_ptr_t<BasicMemory> copy(memory_resource*) const = 0;
+			virtual shared_ptr_t<BasicMemory> copyType(memory_resource*) const = 0;
 		};
 
 		template <class Ty> class Memory : public BasicMemory {
+		public:
 			using value_type = Ty;
-			using memory = std::conditional_t<std::is_empty_v<value_type>, Ty, vector_t<Ty>>; // tiny memory optimization
+			using memory = std::conditional_t<std::is_empty_v<value_type>, Ty, pmr_vector_t<Ty>>; // tiny memory optimization
+
+			Memory(memory_resource* resource) requires(!std::is_empty_v<value_type>) : m_memory(allocator_t<Ty>(resource)) { }
+			Memory(memory_resource*) requires(std::is_empty_v<value_type>) { }
+
+			static shared_ptr_t<BasicMemory> create(memory_resource* resource) {
+				return std::allocate_shared<Memory>(allocator_t<Memory>(resource), resource);
+			}
 
 			bool emptyComponent() const noexcept override {
 				return std::is_empty_v<value_type>;
@@ -59,15 +98,23 @@ private:
 			}
 			void eraseComponent(std::size_t index) override {
 				if constexpr (!std::is_empty_v<value_type>) {
-					auto component = &m_memory[index];
-					auto alloc = m_memory.get_allocator();
+					if (index + 1 != m_memory.size()) { // the last component would be moved into itself after it was destroyed
+						auto component = &m_memory[index];
+						auto alloc = m_memory.get_allocator();
 
-					memory::allocator_traits::destroy(alloc, component); // cursed
-					memory::allocator_traits::construct(alloc, component, std::move(*&*m_memory.rbegin()));
+						memory::allocator_traits::destroy(alloc, component); // cursed
+						memory::allocator_traits::construct(alloc, component, std::move(*&*m_memory.rbegin()));
+					}
 
 					m_memory.pop_back();
 				}
 			}
+			void eraseComponents(const pmr_vector_t<std::size_t>& indices) override { // indices sorted in descending order, so no moved component is erased again
+				for (auto index : indices) Memory::eraseComponent(index);
+			}
+			void clear() override {
+				if constexpr (!std::is_empty_v<value_type>) m_memory.clear();
+			}
 
 			void* componentData(std::size_t index) override {
 				if constexpr (std::is_empty_v<value_type>) return &m_memory;
@@ -91,9 +138,43 @@ private:
 				if constexpr (std::is_empty_v<value_type>) return 1;
 				else return m_memory.size();
 			}
+			std::size_t capacity() const noexcept override {
+				if constexpr (std::is_empty_v<value_type>) return 0;
+				else return m_memory.capacity();
+			}
+			std::size_t elementSize() const noexcept override {
+				if constexpr (std::is_empty_v<value_type>) return 0;
+				else return sizeof(value_type);
+			}
 
-			unique_ptr_t<BasicMemory> copyType() const override {
-				return unique_ptr_t<Memory>::create();
+			void copyBack(const void* data, std::size_t count) override {
+				if constexpr (!std::is_empty_v<value_type>) {
+					if constexpr (std::is_copy_constructible_v<value_type>) {
+						m_memory.reserve(m_memory.size() + count);
+						for (; count > 0; count--) m_memory.emplace_back(*static_cast<const Ty*>(data));
+					} else throw std::logic_error("etcs::detail::Archetype::ComponentAllocator::copyBack(): Component type is not copy constructible!");
+				}
+			}
+
+			void moveBack(BasicMemory& source) override { // source has to be of the same type and is left empty
+				if constexpr (!std::is_empty_v<value_type>) {
+					auto& memory = static_cast<Memory&>(source).m_memory;
+
+					m_memory.reserve(m_memory.size() + memory.size());
+					for (auto& component : memory) m_memory.emplace_back(std::move(component));
+					memory.clear();
+				}
+			}
+
+			shared_ptr_t<BasicMemory> copy(memory_resource* resource) const override {
+				if constexpr (std::is_copy_constructible_v<value_type>) {
+					auto memory = std::allocate_shared<Memory>(allocator_t<Memory>(resource), resource);
+					memory->m_memory = m_memory;
+					return memory;
+				} else throw std::logic_error("etcs::detail::Archetype::ComponentAllocator::copy(): Component type is not copy constructible!");
+			}
+			shared_ptr_t<BasicMemory> copyType(memory_resource* resource) const override {
+				return create(resource);
 			}
 		
 		private:
@@ -104,61 +185,106 @@ private:
 
 	public:
 		ComponentAllocator(ComponentAllocator&&) = default;
-		ComponentAllocator(const ComponentAllocator& other) : m_memory(other.m_memory->copyType()) { }
+		ComponentAllocator(const ComponentAllocator& other) : m_memory(other.m_memory->copyType(other.m_resource)), m_resource(other.m_resource) { }
+		ComponentAllocator(const ComponentAllocator& other, memory_resource* resource) : m_memory(other.m_memory->copyType(resource)), m_resource(resource) { }
 
-		template <class Ty> static ComponentAllocator create() {
+		template <class Ty> static ComponentAllocator create(memory_resource* resource) {
+			ComponentAllocator a;
+			a.m_memory = Memory<Ty>::create(resource);
+			a.m_resource = resource;
+			return a;
+		}
+		static ComponentAllocator share(const ComponentAllocator& other, memory_resource* resource) {
 			ComponentAllocator a;
-			a.m_memory = unique_ptr_t<Memory<Ty>>::create();
+			a.m_memory = other.m_memory;
+			a.m_resource = resource; // copies on write go into the memory of the sharing world
 			return a;
 		}
 
-		bool emptyComponent() {
+		bool emptyComponent() const {
 			return m_memory->emptyComponent();
 		}
 
 		template <class Ty> void* emplaceBack(Ty&& component) {
 			Ty cmp = std::move(component);
-			return m_memory->emplaceBack(&cmp);
+			return writableMemory().emplaceBack(&cmp);
 		}
 		void* emplaceBackData(void* component) {
-			return m_memory->emplaceBack(component);
+			return writableMemory().emplaceBack(component);
 		}
 		void eraseComponent(std::size_t index) {
-			m_memory->eraseComponent(index);
+			writableMemory().eraseComponent(index);
+		}
+		void eraseComponents(const pmr_vector_t<std::size_t>& indices) {
+			writableMemory().eraseComponents(indices);
+		}
+		void clear() {
+			if (m_memory.shared()) m_memory = m_memory->copyType(m_resource); // nothing has to be copied if all of it is erased
+			else m_memory->clear();
+		}
+		void copyBackData(const void* component, std::size_t count) {
+			writableMemory().copyBack(component, count);
+		}
+		void moveBack(ComponentAllocator& other) { // all components of other, which is left empty
+			if (emptyComponent()) return;
+
+			if (count() == 0 && other.m_resource == m_resource) m_memory = std::exchange(other.m_memory, other.m_memory->copyType(other.m_resource)); // relinks the whole column without touching a single component
+			else { // columns of another world are moved into the memory of this one, so they don't keep the other world's memory alive
+				writableMemory().moveBack(other.writableMemory());
+				other.clear();
+			}
 		}
 
 		template <class Ty> Ty* component(std::size_t index) {
-			return static_cast<Ty*>(m_memory->componentData(index));
+			return static_cast<Ty*>(writableMemory().componentData(index));
 		}
 		template <class Ty> const Ty* component(std::size_t index) const {
-			return static_cast<Ty*>(m_memory->componentData(index));
+			return static_cast<const Ty*>(std::as_const(*m_memory).componentData(index));
 		}
 		void* componentData(std::size_t index) {
-			return m_memory->componentData(index);
+			return writableMemory().componentData(index);
 		}
 		const void* componentData(std::size_t index) const {
-			return m_memory->componentData(index);
+			return std::as_const(*m_memory).componentData(index);
 		}
 
 		std::size_t count() const noexcept {
 			return m_memory->count();
 		}
+		std::size_t capacity() const noexcept {
+			return m_memory->capacity();
+		}
+		std::size_t elementSize() const noexcept {
+			return m_memory->elementSize();
+		}
+		bool shared() const noexcept {
+			return m_memory.shared();
+		}
 
-		template <class Ty> Ty* begin() noexcept {
-			return static_cast<Ty*>(m_memory->begin());
+		template <class Ty> Ty* begin() {
+			return static_cast<Ty*>(writableMemory().begin());
 		}
 		template <class Ty> const Ty* begin() const noexcept {
-			return static_cast<const Ty*>(m_memory->begin());
+			return static_cast<const Ty*>(std::as_const(*m_memory).begin());
 		}
 
 	private:
-		unique_ptr_t<BasicMemory> m_memory;
+		CowHandle<BasicMemory> m_memory;
+		memory_resource* m_resource = { };
+
+		BasicMemory& writableMemory() { // copy on write if the memory is shared with a forked world
+			if (m_memory.shared()) m_memory = m_memory->copy(m_resource);
+			return *m_memory;
+		}
 	};
 
 	using component_alloc = ComponentAllocator;
-	using components = lsd::UnorderedSparseMap<lsd::type_id, component_alloc>;
+	using components = lsd::UnorderedSparseMap<lsd::type_id, component_alloc, hash_t<lsd::type_id>, std::equal_to<lsd::type_id>, allocator_t<std::pair<lsd::type_id, component_alloc>>>;
+	using tags = lsd::UnorderedSparseSet<lsd::type_id, hash_t<lsd::type_id>, std::equal_to<lsd::type_id>, allocator_t<lsd::type_id>>;
+	using shared_values = lsd::UnorderedSparseMap<lsd::type_id, SharedValue, hash_t<lsd::type_id>, std::equal_to<lsd::type_id>, allocator_t<std::pair<lsd::type_id, SharedValue>>>;
+	using relations = lsd::UnorderedSparseMap<lsd::type_id, object_id, hash_t<lsd::type_id>, std::equal_to<lsd::type_id>, allocator_t<std::pair<lsd::type_id, object_id>>>;
 
-	using entities = lsd::UnorderedSparseSet<object_id>;
+	using entities = lsd::UnorderedSparseSet<object_id, hash_t<object_id>, std::equal_to<object_id>, allocator_t<object_id>>;
 	
 public:
 	CUSTOM_HASHER(Hasher, const unique_ptr_t<Archetype>&, std::size_t, static_cast<std::size_t>, ->m_hash)
@@ -167,55 +293,91 @@ public:
 	CUSTOM_EQUAL(PtrEqual, const Archetype* const, std::size_t, ->m_hash)
 
 
-	constexpr Archetype() = default;
-	constexpr Archetype(Archetype&&) = default;
+	Archetype(memory_resource* resource = std::pmr::get_default_resource()) : 
+		m_components(allocator_t<std::pair<lsd::type_id, component_alloc>>(resource)), 
+		m_tags(allocator_t<lsd::type_id>(resource)), 
+		m_shared(allocator_t<std::pair<lsd::type_id, SharedValue>>(resource)), 
+		m_relations(allocator_t<std::pair<lsd::type_id, object_id>>(resource)), 
+		m_entities(allocator_t<object_id>(resource)), 
+		m_resource(resource) { }
+	Archetype(Archetype&&) = default;
 
 
 	std::size_t superHash(lsd::type_id typeId);
 	std::size_t subHash(lsd::type_id typeId);
+	std::size_t sharedHash(lsd::type_id typeId, std::size_t handle) const; // replaces the current value if the archetype already has the shared component
+	std::size_t subSharedHash(lsd::type_id typeId) const;
+	std::size_t relationHash(lsd::type_id relation, object_id target) const; // replaces the current target if the archetype already has the relation
+	std::size_t subRelationHash(lsd::type_id relation) const;
+	[[nodiscard]] bool matches(const Archetype& base, const SignatureEdit& edit = { }) const; // if the signature is the one of base with edit applied, distinct signatures can have the same hash
 
 	template <class Ty> Archetype createSuper(std::size_t hash) {
-		Archetype a;
+		Archetype a(m_resource);
 		a.m_hash = hash;
 
-		{ // insert component in the proper ordered position
+		if constexpr (isTag<Ty>) { // the columns stay the same, only the signature changes
+			for (const auto& component : m_components) a.m_components.emplace(component.first, component.second);
+			a.m_tags = m_tags;
+			a.m_shared = m_shared;
+			a.m_relations = m_relations;
+			a.m_tags.emplace(lsd::typeId<Ty>());
+		} else { // insert component in the proper ordered position
 			auto compTypeId = lsd::typeId<Ty>();
 			auto inserted = false;
 			for (const auto& component : m_components) {
-				if (component.first > compTypeId) {
+				if (!inserted && component.first > compTypeId) {
 					inserted = true;
-					a.m_components.emplace(compTypeId, ComponentAllocator::create<Ty>());
+					a.m_components.emplace(compTypeId, ComponentAllocator::create<Ty>(m_resource));
 				}
 
 				a.m_components.emplace(component.first, component.second);
 			}
 
-			if (!inserted) a.m_components.emplace(compTypeId, ComponentAllocator::create<Ty>());
+			if (!inserted) a.m_components.emplace(compTypeId, ComponentAllocator::create<Ty>(m_resource));
+
+			a.m_tags = m_tags;
+			a.m_shared = m_shared;
+			a.m_relations = m_relations;
 		}
 
 		return a;
 	}
 	template <class Ty> Archetype createSub(std::size_t hash) {
-		assert(!m_components.empty() && "etcs::Archetype::createSub(): Cannot create subset archetype of empty archetype!");
+		assert((!m_components.empty() || !m_tags.empty() || !m_shared.empty() || !m_relations.empty()) && "etcs::Archetype::createSub(): Cannot create subset archetype of empty archetype!");
 
-		Archetype a;
+		Archetype a(m_resource);
 		a.m_hash = hash;
 
-		{ // insert component in the proper ordered position
+		if constexpr (isTag<Ty>) {
+			for (const auto& component : m_components) a.m_components.emplace(component.first, component.second);
+			for (auto id : m_tags) if (id != lsd::typeId<Ty>()) a.m_tags.emplace(id);
+			a.m_shared = m_shared;
+			a.m_relations = m_relations;
+		} else { // insert component in the proper ordered position
 			auto compTypeId = lsd::typeId<Ty>();
 			for (const auto& component : m_components)
 				if (component.first != compTypeId) // insert component if it is not of type Ty
 					a.m_components.emplace(component.first, component.second);
+
+			a.m_tags = m_tags;
+			a.m_shared = m_shared;
+			a.m_relations = m_relations;
 		}
 
 		return a;
 	}
+	Archetype createShared(lsd::type_id typeId, SharedValue value, std::size_t hash) const;
+	Archetype createSubShared(lsd::type_id typeId, std::size_t hash) const;
+	Archetype createRelation(lsd::type_id relation, object_id target, std::size_t hash) const;
+	Archetype createSubRelation(lsd::type_id relation, std::size_t hash) const;
+	Archetype copyType(memory_resource* resource) const;
+	Archetype fork(memory_resource* resource) const;
 
 
 	template <class Ty, class... Args> void insertEntityFromSub(object_id entityId, Archetype& subset, Args&&... args) {
 		m_entities.emplace(entityId);
 
-		m_components.at(lsd::typeId<Ty>()).emplaceBack(Ty(std::forward<Args>(args)...));
+		if constexpr (!isTag<Ty>) m_components.at(lsd::typeId<Ty>()).emplaceBack(Ty(std::forward<Args>(args)...));
 
 		auto entityIndex = (subset.m_entities.find(entityId) - subset.m_entities.begin());
 
@@ -232,94 +394,222 @@ public:
 
 		auto entityIndex = (superset.m_entities.find(entityId) - superset.m_entities.begin());
 
-		auto id = lsd::typeId<Ty>();
-
-		for (auto& component : superset.m_components)
-			if (component.first != id) 
+		if constexpr (isTag<Ty>) {
+			for (auto& component : superset.m_components)
 				m_components.at(component.first).emplaceBackData(component.second.componentData(entityIndex));
+		} else {
+			auto id = lsd::typeId<Ty>();
+
+			for (auto& component : superset.m_components)
+				if (component.first != id) 
+					m_components.at(component.first).emplaceBackData(component.second.componentData(entityIndex));
+		}
 
 		superset.eraseEntity(entityId);
 	}
 
+	template <class Ty> void insertEntitiesFromSub(Archetype& subset, const Ty& component) { // all entities of subset, every entity gets a copy of component
+		if constexpr (!isTag<Ty>) m_components.at(lsd::typeId<Ty>()).copyBackData(&component, subset.m_entities.size());
+
+		insertEntitiesFrom(subset);
+	}
+
+	void insertEntityFrom(object_id entityId, Archetype& other); // other has to have the same columns, i.e. only differ in tags, shared components or relations
+	void insertEntitiesFrom(Archetype& other); // all entities of other at once, columns which don't exist in this archetype are dropped
+	void insertEntitiesFrom(Archetype& other, span_t<const object_id> entityIds, span_t<const object_id> sourceIds, memory_resource* scratch); // rows of sourceIds of an archetype with the same columns in another world, inserted as entityIds
 	void insertEntity(object_id entityId);
+	void insertEntitiesFromPrefab(const pmr_vector_t<object_id>& entityIds, const Archetype& prefab);
+	void insertEntityFromPrefab(object_id entityId, const Archetype& prefab);
 	void eraseEntity(object_id entityId);
+	void eraseEntities(span_t<const object_id> entityIds, memory_resource* scratch); // compacts every column only once
 
 	template <class Ty> [[nodiscard]] Ty& component(object_id entityId) {
-		return *m_components.at(lsd::typeId<Ty>()).template component<Ty>(m_entities.find(entityId) - m_entities.begin());
+		static_assert(!isShared<Ty>, "etcs::detail::Archetype::component(): Values of shared components are immutable!");
+
+		if constexpr (isTag<Ty>) return TagInstance<Ty>::get();
+		else return *m_components.at(lsd::typeId<Ty>()).template component<Ty>(m_entities.find(entityId) - m_entities.begin());
 	}
 	template <class Ty> [[nodiscard]] const Ty& component(object_id entityId) const {
-		return *m_components.at(lsd::typeId<Ty>()).template component<Ty>(m_entities.find(entityId) - m_entities.begin());
+		if constexpr (isTag<Ty>) return TagInstance<Ty>::get();
+		else if constexpr (isShared<Ty>) return sharedComponent<Ty>();
+		else return *m_components.at(lsd::typeId<Ty>()).template component<Ty>(m_entities.find(entityId) - m_entities.begin());
+	}
+
+	template <class Ty> [[nodiscard]] const Ty& sharedComponent() const { // the same value for all entities
+		return *static_cast<const Ty*>(m_shared.at(lsd::typeId<Ty>()).value);
 	}
 
 	template <class Ty> [[nodiscard]] bool contains() const {
-		return m_components.contains(lsd::typeId<Ty>());
+		if constexpr (isTag<Ty>) return m_tags.contains(lsd::typeId<Ty>());
+		else if constexpr (isShared<Ty>) return m_shared.contains(lsd::typeId<Ty>());
+		else return m_components.contains(lsd::typeId<Ty>());
+	}
+	[[nodiscard]] bool contains(lsd::type_id typeId) const {
+		return m_components.contains(typeId) || m_tags.contains(typeId) || m_shared.contains(typeId) || m_relations.contains(typeId);
+	}
+	[[nodiscard]] object_id relationTarget(lsd::type_id relation) const { // null if the archetype doesn't have the relation
+		if (auto it = m_relations.find(relation); it != m_relations.end()) return it->second;
+		else return nullId;
 	}
 
-	[[nodiscard]] vector_t<lsd::type_id> typeIds() const;
+	[[nodiscard]] pmr_vector_t<lsd::type_id> typeIds(memory_resource* resource) const;
+	[[nodiscard]] ArchetypeMemoryStats memoryStats() const;
 	[[nodiscard]] std::size_t hash() const noexcept {
 		return m_hash;
 	}
 	[[nodiscard]] bool empty() const noexcept {
 		return m_entities.empty();
 	}
+	[[nodiscard]] const entities& entityIds() const noexcept {
+		return m_entities;
+	}
 
 private:
 	components m_components;
+	tags m_tags;
+	shared_values m_shared;
+	relations m_relations; // target entity of each relation, part of the signature just like the values of shared components
 	entities m_entities;
 
 	std::size_t m_hash = 0;
 
+	memory_resource* m_resource;
+
+	Archetype copySignature(std::size_t hash) const; // sharing the types of the columns, but none of the entities
+
 	friend class Hasher;
 	friend class Equal;
+	friend class ArchetypeManager;
 	friend class detail::BasicEntityQuery;
 	friend class detail::BasicQueryIterator;
+	friend class ::etcs::Prefab;
 };
 
 
+// relation term of a query, matched once per archetype since all of its entities have the same target
+struct RelationFilter {
+	lsd::type_id relation = { };
+	span_t<const lsd::type_id> targetComponents = { }; // the target has to have all of these
+	object_id target = nullId; // any target if null
+};
+
+// type ids of the terms of a query, resolved against the components of each archetype
+struct QueryFilter {
+	span_t<const lsd::type_id> required;
+	span_t<const lsd::type_id> excluded;
+	span_t<const lsd::type_id> anyOf; // alternatives of all any of terms, one term after another
+	span_t<const std::size_t> anyOfEnds; // end of the alternatives of each any of term in anyOf
+	span_t<const lsd::type_id> optional; // doesn't affect which archetypes match
+
+	span_t<const lsd::type_id> sparse; // components in sparse pools, checked per entity, first the required, then the excluded and then the optional ones
+	span_t<const bool> sparseWritable; // if a pool has to be copied when it is shared with a forked world
+	std::size_t sparseRequired = 0;
+	std::size_t sparseExcluded = 0;
+
+	span_t<const RelationFilter> relations; // the relations themselves are also part of the required terms
+
+	[[nodiscard]] bool matchesExclusions(const Archetype& archetype) const; // required terms are resolved through the archetype lookup instead
+};
+
+
+// translation of entity ids from one world into another
+using id_table = lsd::UnorderedSparseMap<object_id, object_id, hash_t<object_id>, std::equal_to<object_id>, allocator_t<std::pair<object_id, object_id>>>;
+
 class ArchetypeManager {
 public:
 	using archetype_handle = unique_ptr_t<Archetype>;
-	using archetype_array = lsd::UnorderedSparseSet<archetype_handle, Archetype::Hasher, Archetype::Equal>;
-	using archetype_lookup = lsd::UnorderedSparseMap<lsd::type_id, vector_t<Archetype*>>;
-
-	ArchetypeManager() { m_archetypes.emplace(archetype_handle::create()); }
+	using archetype_array = lsd::UnorderedSparseSet<archetype_handle, Archetype::Hasher, Archetype::Equal, allocator_t<archetype_handle>>;
+	using archetype_lookup = lsd::UnorderedSparseMap<lsd::type_id, pmr_vector_t<Archetype*>, hash_t<lsd::type_id>, std::equal_to<lsd::type_id>, allocator_t<std::pair<lsd::type_id, pmr_vector_t<Archetype*>>>>;
+	using target_lookup = lsd::UnorderedSparseMap<object_id, pmr_vector_t<Archetype*>, hash_t<object_id>, std::equal_to<object_id>, allocator_t<std::pair<object_id, pmr_vector_t<Archetype*>>>>;
+	using collision_lookup = lsd::UnorderedSparseMap<std::size_t, pmr_vector_t<archetype_handle>, hash_t<std::size_t>, std::equal_to<std::size_t>, allocator_t<std::pair<std::size_t, pmr_vector_t<archetype_handle>>>>;
+
+	ArchetypeManager(WorldMemory* memory) : 
+		m_archetypes(allocator_t<archetype_handle>(memory->resource(AllocationTag::columns))), 
+		m_archetypeLookup(allocator_t<std::pair<lsd::type_id, pmr_vector_t<Archetype*>>>(memory->resource(AllocationTag::columns))), 
+		m_targetLookup(allocator_t<std::pair<object_id, pmr_vector_t<Archetype*>>>(memory->resource(AllocationTag::columns))), 
+		m_collisions(allocator_t<std::pair<std::size_t, pmr_vector_t<archetype_handle>>>(memory->resource(AllocationTag::columns))), 
+		m_released(memory->resource(AllocationTag::columns)), 
+		m_shared(memory), 
+		m_memory(memory) { 
+		m_archetypes.emplace(archetype_handle::create(memory->resource(AllocationTag::columns))); 
+	}
+	ArchetypeManager(const ArchetypeManager& source, WorldMemory* memory);
 
 	template <class Ty> [[nodiscard]] Archetype* addOrFindSuperset(Archetype* baseArchetype) {
 		auto hash = baseArchetype->superHash(lsd::typeId<Ty>());
-		auto archetype = m_archetypes.find(hash);
-
-		if (archetype == m_archetypes.end()) {
-			archetype = m_archetypes.emplace(archetype_handle::create(baseArchetype->createSuper<Ty>(hash))).first;
-
-			for (auto types = (*archetype)->typeIds(); auto id : types)
-				m_archetypeLookup[id].emplace_back(archetype->get());
-		}
-
-		return archetype->get();
+		return addOrFind(hash, *baseArchetype, SignatureEdit { isTag<Ty> ? SignaturePart::tag : SignaturePart::component, lsd::typeId<Ty>() }, [&] { return baseArchetype->createSuper<Ty>(hash); });
 	}
 	template <class Ty> [[nodiscard]] Archetype* addOrFindSubset(Archetype* baseArchetype) {
 		auto hash = baseArchetype->subHash(lsd::typeId<Ty>());
-		auto archetype = m_archetypes.find(hash);
+		return addOrFind(hash, *baseArchetype, SignatureEdit { isTag<Ty> ? SignaturePart::tag : SignaturePart::component, lsd::typeId<Ty>(), true }, [&] { return baseArchetype->createSub<Ty>(hash); });
+	}
 
-		if (archetype == m_archetypes.end()) {
-			archetype = m_archetypes.emplace(archetype_handle::create(baseArchetype->createSub<Ty>(hash))).first;
+	[[nodiscard]] Archetype* addOrFindShared(Archetype* baseArchetype, lsd::type_id typeId, SharedValue value); // with the shared component inserted or set to value
+	[[nodiscard]] Archetype* addOrFindSubsetShared(Archetype* baseArchetype, lsd::type_id typeId);
+	[[nodiscard]] Archetype* addOrFindRelation(Archetype* baseArchetype, lsd::type_id relation, object_id target); // with the relation inserted or retargeted
+	[[nodiscard]] Archetype* addOrFindSubsetRelation(Archetype* baseArchetype, lsd::type_id relation);
+	[[nodiscard]] Archetype* addOrFindSubsetTarget(Archetype* baseArchetype, object_id target); // with every relation to target erased
+	[[nodiscard]] Archetype* addOrFindRelations(const Archetype& archetype); // without any components, but with the same relations as archetype
+	[[nodiscard]] Archetype* addOrFindArchetype(const Archetype& prototype);
+	[[nodiscard]] Archetype* addOrFindTranslated(const Archetype& source, const SharedStorage& sourceShared, const id_table& ids); // of another world, relations to entities which aren't in ids are dropped
 
-			for (auto types = (*archetype)->typeIds(); auto id : types)
-				m_archetypeLookup[id].emplace_back(archetype->get());
-		}
+	void querySupersets(pmr_vector_t<Archetype*>& archetypes, const QueryFilter& filter);
+	void queryRelated(pmr_vector_t<Archetype*>& archetypes, const QueryFilter& filter, object_id target); // only through the archetypes with target in their signature
 
-		return archetype->get();
+	[[nodiscard]] Archetype* findRelated(object_id target); // any archetype with target in its signature which still has entities, null if there is none
+	void releaseRelated(object_id target); // all archetypes with target in their signature, which have to be empty, are destroyed at the next reclaim
+	void reclaim(); // destroys the released archetypes and those with shared values which are still empty, then the values no archetype refers to, only at a point where no query is iterated
+
+	[[nodiscard]] std::size_t generation() const noexcept { // changes whenever archetypes are destroyed, so queries know when to look them up again
+		return m_generation;
+	}
+	void invalidateQueries() noexcept { // for changes which queries resolve once per archetype, like a disabled subtree
+		m_generation++;
 	}
 
-	void querySupersets(vector_t<Archetype*>& archetypes, vector_t<lsd::type_id> types);
+	void memoryStats(WorldMemoryStats& stats) const;
 
 	[[nodiscard]] Archetype* baseArchetype() {
 		return m_archetypes.front().get();
 	}
 
+	[[nodiscard]] SharedStorage& shared() noexcept {
+		return m_shared;
+	}
+	[[nodiscard]] const SharedStorage& shared() const noexcept {
+		return m_shared;
+	}
+
 private:
 	archetype_array m_archetypes;
 	archetype_lookup m_archetypeLookup;
+	target_lookup m_targetLookup; // archetypes by the targets of their relations
+	collision_lookup m_collisions; // archetypes whose hash was already taken by another signature when they were created, practically always empty
+	pmr_vector_t<Archetype*> m_released; // kept alive until the next reclaim, since queries may still point to them
+	std::size_t m_generation = 0;
+
+	SharedStorage m_shared; // values referenced by the signatures of the archetypes
+
+	WorldMemory* m_memory;
+
+	void insertLookup(Archetype* archetype);
+	void eraseLookup(Archetype* archetype);
+
+	Archetype* insertArchetype(archetype_handle&& archetype); // into the collisions if another archetype already has its hash
+	void eraseArchetype(Archetype* archetype);
+
+	template <class Create> Archetype* addOrFind(std::size_t hash, const Archetype& base, const SignatureEdit& edit, Create&& create) { // the archetype with the signature of base with edit applied
+		if (auto archetype = m_archetypes.find(hash); archetype != m_archetypes.end()) {
+			if ((*archetype)->matches(base, edit)) return archetype->get();
+
+			if (auto collisions = m_collisions.find(hash); collisions != m_collisions.end()) 
+				for (const auto& collision : collisions->second) if (collision->matches(base, edit)) return collision.get();
+		}
+
+		ETCS_PROFILE_SCOPE("etcs::ArchetypeManager::createArchetype");
+
+		return insertArchetype(archetype_handle::create(create()));
+	}
 
 	[[nodiscard]] static std::size_t generateHash(const vector_t<std::uintptr_t> types);
 };
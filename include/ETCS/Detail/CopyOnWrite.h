@@ -0,0 +1,93 @@
+/*************************
+ * @file CopyOnWrite.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Handles to memory shared between forked worlds until either of them writes to it
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Core.h"
+
+#include <atomic>
+#include <utility>
+
+namespace etcs {
+
+namespace detail {
+
+template <class> class CowHandle;
+
+// base of memory which can be shared between worlds, counts the handles referring to it
+// the count is explicit, since shared_ptr::use_count() is only a relaxed load and doesn't order the writes after it against the reads of a released handle
+class CowShared {
+public:
+	CowShared() = default;
+	CowShared(const CowShared&) noexcept { } // a copy isn't shared with anyone yet
+
+	CowShared& operator=(const CowShared&) noexcept {
+		return *this;
+	}
+
+private:
+	mutable std::atomic<std::size_t> m_shares = 1;
+
+	template <class> friend class CowHandle;
+};
+
+// shared pointer to memory of one world, which is copied before it is written to if another world still refers to it
+// ownership rule: a handle is only used by the thread currently changing its world, handles of other worlds to the same memory may be copied or released concurrently
+// releasing a handle happens before another handle observes that it isn't shared anymore, so the memory can be written without a copy
+template <class Ty> class CowHandle {
+public:
+	CowHandle() = default;
+	template <class Other> CowHandle(shared_ptr_t<Other> memory) noexcept : m_memory(std::move(memory)) { } // of newly created memory, which starts with a single share
+	CowHandle(const CowHandle& other) noexcept : m_memory(other.m_memory) {
+		if (m_memory) shares().fetch_add(1, std::memory_order_relaxed);
+	}
+	CowHandle(CowHandle&& other) noexcept : m_memory(std::move(other.m_memory)) { }
+	~CowHandle() {
+		release();
+	}
+
+	CowHandle& operator=(CowHandle other) noexcept {
+		std::swap(m_memory, other.m_memory);
+		return *this;
+	}
+
+	[[nodiscard]] bool shared() const noexcept {
+		return m_memory && shares().load(std::memory_order_acquire) > 1;
+	}
+
+	[[nodiscard]] Ty* get() const noexcept {
+		return m_memory.get();
+	}
+	[[nodiscard]] Ty* operator->() const noexcept {
+		return m_memory.get();
+	}
+	[[nodiscard]] Ty& operator*() const noexcept {
+		return *m_memory;
+	}
+	[[nodiscard]] explicit operator bool() const noexcept {
+		return static_cast<bool>(m_memory);
+	}
+
+private:
+	shared_ptr_t<Ty> m_memory;
+
+	std::atomic<std::size_t>& shares() const noexcept {
+		return static_cast<const CowShared&>(*m_memory).m_shares;
+	}
+	void release() noexcept {
+		if (m_memory) shares().fetch_sub(1, std::memory_order_acq_rel);
+		m_memory.reset();
+	}
+};
+
+} // namespace detail
+
+} // namespace etcs
@@ -12,6 +12,10 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <utility>
 
 #ifdef USE_STANDARD_LIBRARY
 
@@ -80,6 +84,7 @@ using object_id = std::uint64_t;
 template <class Ty> using hash_t = std::hash<Ty>;
 
 template <class Ty, class Deleter = std::default_delete<Ty>> using unique_ptr_t = std::unique_ptr<class Ty, class Deleter>;
+template <class Ty> using shared_ptr_t = std::shared_ptr<Ty>;
 
 template <class Ty, class... Args> using function_t = std::function<Ty(Args...)>;
 
@@ -87,6 +92,7 @@ template <class Ty, std::size_t Size> using array_t = std::array<Ty, Size>;
 
 template <class Ty, class Alloc> using vector_t = std::vector<Ty, Alloc>;
 
+template <class CharTy> using char_traits_t = std::char_traits<CharTy>;
 template <class CharTy, class Traits = std::char_traits<CharTy>, class Alloc = std::allocator<CharTy>> using basic_string_t = std::basic_string<CharTy, Traits, Alloc>;
 template <class CharTy, class Traits = std::char_traits<CharTy>> using basic_string_view_t = std::basic_string_view<CharTy, Alloc>;
 
@@ -95,6 +101,7 @@ template <class CharTy, class Traits = std::char_traits<CharTy>> using basic_str
 template <class Ty> using hash_t = lsd::Hash<Ty>;
 
 template <class Ty, class Deleter = lsd::DefaultDelete<Ty>> using unique_ptr_t = lsd::UniquePointer<Ty, Deleter>;
+template <class Ty> using shared_ptr_t = std::shared_ptr<Ty>; // shared ownership is only used for copy on write world forks
 
 template <class Ty, class... Args> using function_t = lsd::Function<Ty(Args...)>;
 
@@ -102,6 +109,7 @@ template <class Ty, std::size_t Size> using array_t = lsd::Array<Ty, Size>;
 
 template <class Ty, class Alloc = std::allocator<Ty>> using vector_t = lsd::Vector<Ty, Alloc>;
 
+template <class CharTy> using char_traits_t = lsd::CharTraits<CharTy>;
 template <class CharTy, class Traits = lsd::CharTraits<CharTy>, class Alloc = std::allocator<CharTy>> using basic_string_t = lsd::BasicString<CharTy, Traits, Alloc>;
 template <class CharTy, class Traits = lsd::CharTraits<CharTy>> using basic_string_view_t = lsd::BasicStringView<CharTy, Traits>;
 
@@ -111,14 +119,30 @@ using string_t = basic_string_t<char>;
 using string_view_t = basic_string_view_t<char>;
 
 
+// memory resources used by the containers of a world
+
+using memory_resource = std::pmr::memory_resource;
+template <class Ty> using allocator_t = std::pmr::polymorphic_allocator<Ty>;
+
+template <class Ty> using pmr_vector_t = vector_t<Ty, allocator_t<Ty>>;
+
+template <class Ty, std::size_t Extent = std::dynamic_extent> using span_t = std::span<Ty, Extent>;
+using pmr_string_t = basic_string_t<char, char_traits_t<char>, allocator_t<char>>;
+
+
 // forward declarations
 
 class Entity;
 class BasicSystem;
 class World;
+class Prefab;
 
 class EntityRange;
 class RangeIterator;
+class SpawnBuffer;
+class StagedWorld;
+class ReadAccess;
+class WriteAccess;
 template <class, class...> class EntityQuery;
 template <class, class...> class QueryIterator;
 
@@ -139,6 +163,7 @@ class BasicQueryIterator;
 
 class WorldManager;
 class WorldData;
+class WorldMemory;
 
 } // namespace detail
 
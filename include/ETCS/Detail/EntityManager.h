@@ -15,6 +15,13 @@
 #include <LSD/UnorderedSparseMap.h>
 
 #include "Core.h"
+#include "ArchetypeManager.h"
+#include "SparseStorage.h"
+#include "WorldMemory.h"
+
+#include "../MemoryStats.h"
+
+#include <utility>
 
 namespace etcs {
 
@@ -31,25 +38,77 @@ CUSTOM_HASHER(EVHasher, const EntityView&, string_view_t, hash_t<string_view_t>{
 CUSTOM_EQUAL(EVEqual, const EntityView&, string_view_t, .name)
 
 
+// name of an entity, always allocated out of line unlike a string with a small buffer
+// the views of the parent and the children point into the allocation, which stays in place when the entity data is moved inside the lookup
+class EntityName {
+public:
+	EntityName(string_view_t name, memory_resource* resource);
+	EntityName(EntityName&& other) noexcept : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)), m_resource(other.m_resource) { }
+	EntityName(const EntityName&) = delete;
+	~EntityName();
+
+	EntityName& operator=(EntityName&& other) noexcept;
+	EntityName& operator=(const EntityName&) = delete;
+
+	void assign(string_view_t name); // all views of the previous name are invalidated
+
+	[[nodiscard]] string_view_t view() const noexcept {
+		return m_data ? string_view_t(m_data, m_size) : string_view_t();
+	}
+	operator string_view_t() const noexcept {
+		return view();
+	}
+
+	[[nodiscard]] std::size_t allocatedBytes() const noexcept {
+		return m_data ? m_size : 0;
+	}
+
+private:
+	char* m_data = nullptr; // null for an empty name
+	std::size_t m_size = 0;
+
+	memory_resource* m_resource;
+
+	void release() noexcept;
+};
+
+
+// entity whose id was reserved on another thread, inserted when its spawn buffer is published
+struct ReservedEntity {
+	object_id id = nullId;
+	const Prefab* prefab = nullptr; // instance of the prefab, which also names it if set
+	string_t name = { };
+};
+
+
 // Core entity data
 class EntityData {
 public:
-	constexpr EntityData(object_id id, string_view_t name) : m_id(id), m_name(name) { }
-	constexpr EntityData(object_id id, string_view_t name, EntityData* parent) : m_id(id), m_parent({ parent->m_id, parent->m_name }), m_name(name) {
-		parent->m_children.emplace(EntityView { m_id, m_name });
-	}
+	using children = lsd::UnorderedSparseSet<EntityView, EVHasher, EVEqual, allocator_t<EntityView>>;
+
+	EntityData(object_id id, string_view_t name, WorldMemory* memory) : 
+		m_id(id), 
+		m_name(name, memory->resource(AllocationTag::names)), 
+		m_children(allocator_t<EntityView>(memory->resource(AllocationTag::children))) { }
+	EntityData(object_id id, string_view_t name, EntityData* parent, WorldMemory* memory) : 
+		m_id(id), 
+		m_parent({ parent->m_id, parent->m_name }), 
+		m_name(name, memory->resource(AllocationTag::names)), 
+		m_children(allocator_t<EntityView>(memory->resource(AllocationTag::children))),
+		m_depth(parent->m_depth + 1) { }
 
 private:
 	object_id m_id;
 	EntityView m_parent;
 
-	string_t m_name;
-	lsd::UnorderedSparseSet<EntityView, EVHasher, EVEqual> m_children;
+	EntityName m_name;
+	children m_children;
 
-	bool m_active = true;
+	std::size_t m_depth = 0; // distance to the root of the hierarchy, kept up to date whenever the parent changes
 
 	friend class BasicQueryIterator;
 	friend class EntityManager;
+	friend class WorldData;
 	friend class ::etcs::World;
 	friend class ::etcs::Entity;
 };
@@ -62,11 +121,26 @@ private:
 	CUSTOM_EQUAL(Equal, const EntityData&, object_id, .m_id)
 
 public:
-	constexpr EntityManager(WorldData* world) noexcept : m_world(world) { }
+	EntityManager(WorldData* world, WorldMemory* memory) : 
+		m_lookup(allocator_t<std::pair<EntityData, Archetype*>>(memory->resource(AllocationTag::entities))), 
+		m_unused(allocator_t<object_id>(memory->resource(AllocationTag::entities))), 
+		m_sparse(memory), 
+		m_world(world), 
+		m_memory(memory) { }
+	EntityManager(const EntityManager& source, WorldData* world, WorldMemory* memory);
 
 	[[nodiscard]] Entity insert(string_view_t name);
 	[[nodiscard]] Entity insert(string_view_t name, object_id parentId);
-	void erase(object_id id);
+	[[nodiscard]] vector_t<Entity> insert(const Prefab& prefab, std::size_t count);
+	void erase(object_id id); // hands the children of the entity to its parent
+	void eraseSubtrees(span_t<const Entity> entities); // the entities with all of their descendants, grouped by archetype
+	void reparent(span_t<const Entity> entities, object_id parentId);
+	[[nodiscard]] vector_t<Entity> insertFrom(EntityManager& source, span_t<const Entity> entities); // moves the entities with all of their descendants out of another world, in the order of entities
+	void insertFrom(EntityManager& source); // all entities of another world
+
+	void insertReserved(span_t<const ReservedEntity> entities); // at a sync point, grouped by prefab so every archetype is filled in one go
+	[[nodiscard]] object_id reserveIds(std::size_t count); // first id of a block of count ids, from any thread without locking
+	void releaseIds(object_id first, std::size_t count); // reserved ids which weren't used, on the thread owning the world
 
 	void clear(object_id id);
 
@@ -78,6 +152,9 @@ public:
 	[[nodiscard]] Archetype*& archetype(object_id id, std::size_t& index);
 	[[nodiscard]] const Archetype* archetype(object_id id, std::size_t& index) const;
 
+	void updateDepth(object_id id, std::size_t depth); // of the entity and all of its descendants
+	[[nodiscard]] std::size_t depth(const Archetype& archetype) const; // of all entities in the archetype, since they share the same parent
+
 	[[nodiscard]] Entity find(object_id entityId) const;
 	[[nodiscard]] Entity at(std::size_t index) const;
 
@@ -85,13 +162,32 @@ public:
 		return m_lookup.size();
 	}
 
+	[[nodiscard]] SparseStorage& sparse() noexcept {
+		return m_sparse;
+	}
+	[[nodiscard]] const SparseStorage& sparse() const noexcept {
+		return m_sparse;
+	}
+
+	[[nodiscard]] EntityMemoryStats memoryStats() const;
+
 private:
-	lsd::UnorderedSparseMap<EntityData, Archetype*, Hasher, Equal> m_lookup;
-	vector_t<object_id> m_unused;
+	lsd::UnorderedSparseMap<EntityData, Archetype*, Hasher, Equal, allocator_t<std::pair<EntityData, Archetype*>>> m_lookup;
+	pmr_vector_t<object_id> m_unused; // erased ids, only recycled by the thread owning the world
+	std::atomic<object_id> m_nextId = 0; // never handed out before, shared with threads reserving ids
+
+	SparseStorage m_sparse; // components which don't belong to the archetype of their entity
 
 	WorldData* m_world;
+	WorldMemory* m_memory;
 
 	object_id uniqueId();
+
+	void linkChild(EntityData& parent, EntityData& child); // renames the child to name#id if the parent already has a child with its name, repeated until the name is unique
+	void unlinkChild(EntityData& parent, const EntityData& child); // only if the child view with its name actually refers to it
+	void spliceFrom(EntityManager& source, id_table& ids); // ids of source have to be the keys of ids, the translated ids are assigned here
+
+	void insertPrefabRows(const Prefab& prefab, const pmr_vector_t<object_id>& parents, std::size_t count, pmr_vector_t<object_id>& ids); // ids already in ids are used for the first rows
 };
 
 } // namespace detail
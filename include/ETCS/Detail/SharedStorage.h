@@ -0,0 +1,196 @@
+/*************************
+ * @file SharedStorage.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Deduplicated values of shared components
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include <LSD/Utility.h>
+#include <LSD/UnorderedSparseMap.h>
+#include <LSD/UnorderedSparseSet.h>
+
+#include "Core.h"
+#include "WorldMemory.h"
+
+#include "../ComponentTraits.h"
+#include "../MemoryStats.h"
+
+#include <stdexcept>
+
+namespace etcs {
+
+namespace detail {
+
+// value of a shared component in the signature of an archetype, the handle identifies the value in the pool of its type
+struct SharedValue {
+	std::size_t handle = 0;
+	const void* value = nullptr;
+};
+
+// counts the archetypes referring to every value, values which no archetype refers to anymore are only erased at the next sync point
+class BasicSharedPool {
+public:
+	BasicSharedPool(memory_resource* resource) : m_references(resource), m_unused(resource), m_unreferenced(resource) { }
+	virtual ~BasicSharedPool() { }
+
+	void reference(std::size_t handle) noexcept {
+		m_references[handle]++;
+	}
+	void release(std::size_t handle) {
+		if (--m_references[handle] == 0) m_unreferenced.push_back(handle);
+	}
+	void reclaim(); // erases the values which are still unreferenced, their handles are reused afterwards
+
+	virtual std::size_t size() const noexcept = 0;
+	virtual std::size_t elementSize() const noexcept = 0;
+
+	virtual SharedValue insertFrom(const BasicSharedPool&, std::size_t) = 0;
+
+	virtual shared_ptr_t<BasicSharedPool> copy(memory_resource*) const = 0;
+	virtual shared_ptr_t<BasicSharedPool> copyType(memory_resource*) const = 0;
+
+protected:
+	std::size_t insertHandle(); // unreferenced until an archetype with the value is created
+	void copyHandles(const BasicSharedPool& source); // all values are unreferenced until the archetypes of the copy are inserted
+
+	virtual bool eraseValue(std::size_t handle) = 0; // false if the handle was already unused
+
+private:
+	pmr_vector_t<std::size_t> m_references; // by handle
+	pmr_vector_t<std::size_t> m_unused; // handles of erased values
+	pmr_vector_t<std::size_t> m_unreferenced; // values which may be erased at the next sync point
+};
+
+// values are immutable, their handles and addresses stay valid as long as an archetype refers to them
+template <class Ty> class SharedPool : public BasicSharedPool {
+private:
+	using value_handle = shared_ptr_t<const Ty>;
+
+	class Hasher {
+	public:
+		std::size_t operator()(const value_handle& value) const noexcept {
+			return hash_t<Ty>()(*value);
+		}
+		std::size_t operator()(const Ty& value) const noexcept {
+			return hash_t<Ty>()(value);
+		}
+	};
+	class Equal {
+	public:
+		bool operator()(const value_handle& first, const value_handle& second) const noexcept {
+			return *first == *second;
+		}
+		bool operator()(const value_handle& first, const Ty& second) const noexcept {
+			return *first == second;
+		}
+		bool operator()(const Ty& first, const value_handle& second) const noexcept {
+			return first == *second;
+		}
+	};
+
+public:
+	SharedPool(memory_resource* resource) : 
+		BasicSharedPool(resource), 
+		m_handles(allocator_t<std::pair<value_handle, std::size_t>>(resource)), 
+		m_values(allocator_t<value_handle>(resource)), 
+		m_resource(resource) { }
+
+	[[nodiscard]] SharedValue insert(Ty&& value) { // returns the existing value if an equal one was inserted before
+		if (auto it = m_handles.find(value); it != m_handles.end()) return SharedValue { it->second, it->first.get() };
+		else return insertValue(std::allocate_shared<const Ty>(allocator_t<Ty>(m_resource), std::move(value)));
+	}
+
+	SharedValue insertFrom(const BasicSharedPool& source, std::size_t handle) override { // value of a pool of another world, copied into the memory of this one
+		const auto& value = static_cast<const SharedPool&>(source).m_values[handle];
+
+		if (auto it = m_handles.find(*value); it != m_handles.end()) return SharedValue { it->second, it->first.get() };
+		else if constexpr (std::is_copy_constructible_v<Ty>) return insertValue(std::allocate_shared<const Ty>(allocator_t<Ty>(m_resource), *value));
+		else throw std::logic_error("etcs::detail::SharedPool::insertFrom(): Component type is not copy constructible!");
+	}
+
+	std::size_t size() const noexcept override {
+		return m_handles.size();
+	}
+	std::size_t elementSize() const noexcept override {
+		return sizeof(Ty);
+	}
+
+	shared_ptr_t<BasicSharedPool> copy(memory_resource* resource) const override { // the values themselves are shared by both pools
+		auto pool = std::allocate_shared<SharedPool>(allocator_t<SharedPool>(resource), resource);
+		pool->copyHandles(*this);
+		pool->m_handles = m_handles;
+		pool->m_values = m_values;
+		return pool;
+	}
+	shared_ptr_t<BasicSharedPool> copyType(memory_resource* resource) const override {
+		return std::allocate_shared<SharedPool>(allocator_t<SharedPool>(resource), resource);
+	}
+
+private:
+	lsd::UnorderedSparseMap<value_handle, std::size_t, Hasher, Equal, allocator_t<std::pair<value_handle, std::size_t>>> m_handles; // of every value, to find equal ones
+	pmr_vector_t<value_handle> m_values; // by handle, null if the handle is unused
+
+	memory_resource* m_resource;
+
+	SharedValue insertValue(value_handle&& value) {
+		auto handle = insertHandle();
+		if (handle == m_values.size()) m_values.emplace_back(value);
+		else m_values[handle] = value;
+
+		m_handles.emplace(std::move(value), handle);
+		return SharedValue { handle, m_values[handle].get() };
+	}
+
+	bool eraseValue(std::size_t handle) override {
+		if (!m_values[handle]) return false;
+
+		m_handles.erase(m_handles.find(*m_values[handle]));
+		m_values[handle] = nullptr;
+		return true;
+	}
+};
+
+
+class SharedStorage {
+public:
+	using pool_handle = shared_ptr_t<BasicSharedPool>;
+
+	SharedStorage(WorldMemory* memory) : m_pools(allocator_t<std::pair<lsd::type_id, pool_handle>>(memory->resource(AllocationTag::columns))), m_memory(memory) { }
+	SharedStorage(const SharedStorage& source, WorldMemory* memory);
+
+	template <class Ty> [[nodiscard]] SharedPool<Ty>& pool() {
+		auto& handle = m_pools[lsd::typeId<Ty>()];
+		if (!handle) handle = std::allocate_shared<SharedPool<Ty>>(allocator_t<SharedPool<Ty>>(m_memory->resource(AllocationTag::columns)), m_memory->resource(AllocationTag::columns));
+
+		return static_cast<SharedPool<Ty>&>(*handle);
+	}
+
+	[[nodiscard]] SharedValue insertFrom(lsd::type_id typeId, const SharedStorage& source, std::size_t handle); // translates a value of another world into this one
+
+	void reference(lsd::type_id typeId, std::size_t handle) noexcept { // by a newly inserted archetype
+		m_pools.at(typeId)->reference(handle);
+	}
+	void release(lsd::type_id typeId, std::size_t handle) { // by an erased archetype
+		m_pools.at(typeId)->release(handle);
+	}
+	void reclaim(); // of the values of all pools which no archetype refers to anymore
+
+	[[nodiscard]] pmr_vector_t<lsd::type_id> typeIds(memory_resource* resource) const; // of all pools
+
+	void memoryStats(WorldMemoryStats& stats) const;
+
+private:
+	lsd::UnorderedSparseMap<lsd::type_id, pool_handle, hash_t<lsd::type_id>, std::equal_to<lsd::type_id>, allocator_t<std::pair<lsd::type_id, pool_handle>>> m_pools;
+
+	WorldMemory* m_memory;
+};
+
+} // namespace detail
+
+} // namespace etcs
@@ -0,0 +1,178 @@
+/*************************
+ * @file SparseStorage.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Sparse set pools for components which are stored outside of the archetypes
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include <LSD/Utility.h>
+#include <LSD/UnorderedSparseMap.h>
+
+#include "Core.h"
+#include "CopyOnWrite.h"
+#include "WorldMemory.h"
+
+#include "../ComponentTraits.h"
+#include "../MemoryStats.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace etcs {
+
+namespace detail {
+
+// dense array of entity ids with a paged sparse index into it, the components are stored by the typed pool in the same order
+class BasicSparsePool : public CowShared {
+public:
+	static constexpr std::size_t pageSize = 4096;
+	static constexpr std::size_t nullIndex = std::numeric_limits<std::size_t>::max();
+
+	BasicSparsePool(memory_resource* resource) : m_ids(allocator_t<object_id>(resource)), m_pages(allocator_t<std::size_t*>(resource)), m_resource(resource) { }
+	BasicSparsePool(const BasicSparsePool& other, memory_resource* resource);
+	BasicSparsePool(const BasicSparsePool&) = delete;
+	virtual ~BasicSparsePool();
+
+	BasicSparsePool& operator=(const BasicSparsePool&) = delete;
+
+	[[nodiscard]] std::size_t index(object_id entityId) const noexcept {
+		auto page = entityId / pageSize;
+		return (page < m_pages.size() && m_pages[page]) ? m_pages[page][entityId % pageSize] : nullIndex;
+	}
+	[[nodiscard]] bool contains(object_id entityId) const noexcept {
+		return index(entityId) != nullIndex;
+	}
+
+	void erase(object_id entityId); // moves the last component into the gap, does nothing if the entity isn't in the pool
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return m_ids.size();
+	}
+	[[nodiscard]] const pmr_vector_t<object_id>& ids() const noexcept { // in the order of the components
+		return m_ids;
+	}
+	[[nodiscard]] std::size_t indexBytes() const noexcept;
+
+	virtual std::size_t capacity() const noexcept = 0;
+	virtual std::size_t elementSize() const noexcept = 0;
+
+	virtual void moveFrom(BasicSparsePool&, object_id, object_id) = 0;
+
+	virtual shared_ptr_t<BasicSparsePool> copy(memory_resource*) const = 0;
+	virtual shared_ptr_t<BasicSparsePool> copyType(memory_resource*) const = 0;
+
+protected:
+	memory_resource* resource() const noexcept {
+		return m_resource;
+	}
+
+	void insertId(object_id entityId);
+
+	virtual void eraseComponent(std::size_t index) = 0;
+
+private:
+	pmr_vector_t<object_id> m_ids;
+	pmr_vector_t<std::size_t*> m_pages; // allocated when the first entity in their range is inserted
+
+	memory_resource* m_resource;
+};
+
+template <class Ty> class SparsePool : public BasicSparsePool {
+public:
+	using value_type = Ty;
+
+	SparsePool(memory_resource* resource) : BasicSparsePool(resource), m_components(allocator_t<Ty>(resource)) { }
+	SparsePool(const SparsePool& other, memory_resource* resource) : BasicSparsePool(other, resource), m_components(other.m_components, allocator_t<Ty>(resource)) { }
+
+	template <class... Args> Ty& emplace(object_id entityId, Args&&... args) {
+		insertId(entityId);
+		return m_components.emplace_back(std::forward<Args>(args)...);
+	}
+
+	[[nodiscard]] Ty& get(object_id entityId) {
+		return m_components[index(entityId)];
+	}
+	[[nodiscard]] const Ty& get(object_id entityId) const {
+		return m_components[index(entityId)];
+	}
+
+	std::size_t capacity() const noexcept override {
+		return m_components.capacity();
+	}
+	std::size_t elementSize() const noexcept override {
+		return sizeof(value_type);
+	}
+
+	void moveFrom(BasicSparsePool& source, object_id sourceId, object_id entityId) override { // the component of sourceId in a pool of the same type, e.g. of another world
+		auto& pool = static_cast<SparsePool&>(source);
+
+		emplace(entityId, std::move(pool.get(sourceId)));
+		pool.erase(sourceId);
+	}
+
+	shared_ptr_t<BasicSparsePool> copy(memory_resource* resource) const override {
+		if constexpr (std::is_copy_constructible_v<value_type>) return std::allocate_shared<SparsePool>(allocator_t<SparsePool>(resource), *this, resource);
+		else throw std::logic_error("etcs::detail::SparsePool::copy(): Component type is not copy constructible!");
+	}
+	shared_ptr_t<BasicSparsePool> copyType(memory_resource* resource) const override {
+		return std::allocate_shared<SparsePool>(allocator_t<SparsePool>(resource), resource);
+	}
+
+private:
+	pmr_vector_t<Ty> m_components;
+
+	void eraseComponent(std::size_t index) override {
+		if (index + 1 != m_components.size()) m_components[index] = std::move(m_components.back());
+		m_components.pop_back();
+	}
+};
+
+
+class SparseStorage {
+public:
+	using pool_handle = CowHandle<BasicSparsePool>;
+
+	SparseStorage(WorldMemory* memory) : m_pools(allocator_t<std::pair<lsd::type_id, pool_handle>>(memory->resource(AllocationTag::columns))), m_memory(memory) { }
+	SparseStorage(const SparseStorage& source, WorldMemory* memory) : 
+		m_pools(source.m_pools, allocator_t<std::pair<lsd::type_id, pool_handle>>(memory->resource(AllocationTag::columns))), 
+		m_memory(memory) { } // pools are shared until either world writes to them
+
+	template <class Ty> [[nodiscard]] SparsePool<Ty>& pool() { // creates the pool if it doesn't exist yet
+		auto& handle = m_pools[lsd::typeId<Ty>()];
+		if (!handle) handle = std::allocate_shared<SparsePool<Ty>>(allocator_t<SparsePool<Ty>>(m_memory->resource(AllocationTag::columns)), m_memory->resource(AllocationTag::columns));
+
+		return static_cast<SparsePool<Ty>&>(writable(handle));
+	}
+	template <class Ty> [[nodiscard]] const SparsePool<Ty>* find() const {
+		return static_cast<const SparsePool<Ty>*>(find(lsd::typeId<Ty>()));
+	}
+	[[nodiscard]] BasicSparsePool* find(lsd::type_id typeId) const; // doesn't copy shared pools, so only for reading
+	[[nodiscard]] BasicSparsePool* findWritable(lsd::type_id typeId);
+
+	template <class Ty> [[nodiscard]] bool contains(object_id entityId) const {
+		auto pool = find(lsd::typeId<Ty>());
+		return pool && pool->contains(entityId);
+	}
+
+	void erase(object_id entityId); // from all pools
+	void moveFrom(SparseStorage& source, object_id sourceId, object_id entityId); // all components of sourceId in another world
+
+	void memoryStats(WorldMemoryStats& stats) const;
+
+private:
+	lsd::UnorderedSparseMap<lsd::type_id, pool_handle, hash_t<lsd::type_id>, std::equal_to<lsd::type_id>, allocator_t<std::pair<lsd::type_id, pool_handle>>> m_pools;
+
+	WorldMemory* m_memory;
+
+	BasicSparsePool& writable(pool_handle& handle);
+};
+
+} // namespace detail
+
+} // namespace etcs
@@ -14,8 +14,12 @@
 #include "Core.h"
 #include "ArchetypeManager.h"
 #include "EntityManager.h"
+#include "WorldMemory.h"
+#include "AccessGuard.h"
 
 #include "../Component.h"
+#include "../PerfCounters.h"
+#include "../Relation.h"
 
 namespace etcs {
 
@@ -23,45 +27,230 @@ namespace detail {
 
 class WorldData {
 private:
-	using pointer_type = unique_ptr_t<WorldData>;
-
-	CUSTOM_HASHER(Hasher, const pointer_type&, const string_t&, hash_t<string_t>(), ->m_name)
-	CUSTOM_EQUAL(Equal, const pointer_type&, const string_t&, ->m_name)
+	CUSTOM_HASHER(Hasher, const WorldData*, const string_t&, hash_t<string_t>(), ->m_name)
+	CUSTOM_EQUAL(Equal, const WorldData*, const string_t&, ->m_name)
 
 public:
-	WorldData(string_view_t name) : m_archetypes(), m_entities(this), m_name(name) { }
+	WorldData(string_view_t name, memory_resource* upstream = std::pmr::get_default_resource()) : 
+		m_memory(std::make_shared<WorldMemory>(upstream)),
+		m_archetypes(m_memory.get()), 
+		m_entities(this, m_memory.get()), 
+		m_name(name) { }
+	WorldData(string_view_t name, const shared_ptr_t<WorldMemory>& target) : // allocates its columns from the memory of the world it will be merged into
+		m_memory(std::make_shared<WorldMemory>(target->upstream(), target->resource(AllocationTag::columns))),
+		m_archetypes(m_memory.get()), 
+		m_entities(this, m_memory.get()), 
+		m_name(name) {
+		m_sharedMemory.push_back(target); // keep the memory of the columns alive
+	}
+	WorldData(const WorldData& source, string_view_t name) : 
+		m_memory(std::make_shared<WorldMemory>(source.m_memory->upstream())),
+		m_sharedMemory(source.m_sharedMemory),
+		m_archetypes(source.m_archetypes, m_memory.get()), 
+		m_entities(source.m_entities, this, m_memory.get()), 
+		m_name(name) {
+		m_sharedMemory.push_back(source.m_memory); // keep the memory of columns shared with the source world alive
+	}
 
 private:
 	template <class Ty, class... Args> ComponentView<Ty> insertComponent(object_id entityId, std::size_t& index, Args&&... args) {
+		ETCS_PROFILE_SCOPE("etcs::World::insertComponent");
+		ETCS_COMPONENT_WRITE_SCOPE(m_access, "etcs::World::insertComponent", Ty);
+		ETCS_PERF_SCOPE(m_perfCounters, componentInsertion);
+
 		auto& base = m_entities.archetype(entityId, index);
-		if (base->contains<Ty>()) throw std::out_of_range("etcs::detail::WorldData::insertComponent(): A component was requested to be inserted into an entity which already has that component!");
 
-		auto archetype = m_archetypes.addOrFindSuperset<Ty>(base);
-		archetype->template insertEntityFromSub<Ty>(entityId, *base, std::forward<Args>(args)...);
+		if constexpr (isSparse<Ty>) { // the entity stays in its archetype
+			if (m_entities.sparse().contains<Ty>(entityId)) throw std::out_of_range("etcs::detail::WorldData::insertComponent(): A component was requested to be inserted into an entity which already has that component!");
 
-		base = archetype;
+			m_entities.sparse().pool<Ty>().emplace(entityId, std::forward<Args>(args)...);
+		} else if constexpr (isShared<Ty>) { // only the signature changes, the entity is grouped with all others of the same value
+			if (base->contains<Ty>()) throw std::out_of_range("etcs::detail::WorldData::insertComponent(): A component was requested to be inserted into an entity which already has that component!");
+
+			auto archetype = m_archetypes.addOrFindShared(base, lsd::typeId<Ty>(), m_archetypes.shared().pool<Ty>().insert(Ty(std::forward<Args>(args)...)));
+			archetype->insertEntityFrom(entityId, *base);
+
+			base = archetype;
+		} else {
+			if (base->contains<Ty>()) throw std::out_of_range("etcs::detail::WorldData::insertComponent(): A component was requested to be inserted into an entity which already has that component!");
+
+			auto archetype = m_archetypes.addOrFindSuperset<Ty>(base);
+			archetype->template insertEntityFromSub<Ty>(entityId, *base, std::forward<Args>(args)...);
+
+			base = archetype;
+		}
 
 		return ComponentView<Ty>(entityId, index, &m_entities);
 	}
 	template <class Ty> void eraseComponent(object_id entityId, std::size_t& index) {
+		ETCS_PROFILE_SCOPE("etcs::World::eraseComponent");
+		ETCS_COMPONENT_WRITE_SCOPE(m_access, "etcs::World::eraseComponent", Ty);
+		ETCS_PERF_SCOPE(m_perfCounters, componentErasure);
+
 		auto& base = m_entities.archetype(entityId, index);
-		if (!base->contains<Ty>()) throw std::out_of_range("etcs::detail::WorldData::eraseComponent(): A component was requested to be erased from an entity which doesn't have that component!");
 
-		detail::Archetype* archetype = m_archetypes.addOrFindSubset<Ty>(base);
-		archetype->insertEntityFromSuper<Ty>(entityId, *base);
+		if constexpr (isSparse<Ty>) {
+			if (!m_entities.sparse().contains<Ty>(entityId)) throw std::out_of_range("etcs::detail::WorldData::eraseComponent(): A component was requested to be erased from an entity which doesn't have that component!");
+
+			m_entities.sparse().pool<Ty>().erase(entityId);
+		} else if constexpr (isShared<Ty>) {
+			if (!base->contains<Ty>()) throw std::out_of_range("etcs::detail::WorldData::eraseComponent(): A component was requested to be erased from an entity which doesn't have that component!");
+
+			auto archetype = m_archetypes.addOrFindSubsetShared(base, lsd::typeId<Ty>());
+			archetype->insertEntityFrom(entityId, *base);
+
+			base = archetype;
+		} else {
+			if (!base->contains<Ty>()) throw std::out_of_range("etcs::detail::WorldData::eraseComponent(): A component was requested to be erased from an entity which doesn't have that component!");
+
+			detail::Archetype* archetype = m_archetypes.addOrFindSubset<Ty>(base);
+			archetype->insertEntityFromSuper<Ty>(entityId, *base);
+
+			base = archetype;
+		}
+	}
+
+	template <class Ty> void insertComponentAll(Archetype* base, const Ty& component) { // into all entities of base at once, so every column is only relinked or appended once
+		ETCS_PROFILE_SCOPE("etcs::World::insertComponentAll");
+		ETCS_COMPONENT_WRITE_SCOPE(m_access, "etcs::World::insertComponentAll", Ty);
+		ETCS_PERF_SCOPE(m_perfCounters, componentInsertion);
+
+		if constexpr (isSparse<Ty>) {
+			auto& pool = m_entities.sparse().pool<Ty>();
+			for (auto id : base->entityIds()) if (!pool.contains(id)) pool.emplace(id, component);
+		} else {
+			if (base->empty() || base->contains<Ty>()) return;
+
+			Archetype* archetype;
+			if constexpr (isShared<Ty>) archetype = m_archetypes.addOrFindShared(base, lsd::typeId<Ty>(), m_archetypes.shared().pool<Ty>().insert(Ty(component)));
+			else archetype = m_archetypes.addOrFindSuperset<Ty>(base);
+
+			relinkEntities(*base, archetype);
+
+			if constexpr (isShared<Ty>) archetype->insertEntitiesFrom(*base);
+			else archetype->template insertEntitiesFromSub<Ty>(*base, component);
+		}
+	}
+	template <class Ty> void eraseComponentAll(Archetype* base) {
+		ETCS_PROFILE_SCOPE("etcs::World::eraseComponentAll");
+		ETCS_COMPONENT_WRITE_SCOPE(m_access, "etcs::World::eraseComponentAll", Ty);
+		ETCS_PERF_SCOPE(m_perfCounters, componentErasure);
+
+		if constexpr (isSparse<Ty>) {
+			if (auto pool = m_entities.sparse().findWritable(lsd::typeId<Ty>()); pool)
+				for (auto id : base->entityIds()) pool->erase(id);
+		} else {
+			if (base->empty() || !base->contains<Ty>()) return;
+
+			Archetype* archetype;
+			if constexpr (isShared<Ty>) archetype = m_archetypes.addOrFindSubsetShared(base, lsd::typeId<Ty>());
+			else archetype = m_archetypes.addOrFindSubset<Ty>(base);
+
+			relinkEntities(*base, archetype);
+			archetype->insertEntitiesFrom(*base);
+		}
+	}
+	void relinkEntities(const Archetype& base, Archetype* archetype) { // before all entities of base are moved to archetype
+		for (auto id : base.entityIds()) {
+			auto index = std::numeric_limits<std::size_t>::max();
+			m_entities.archetype(id, index) = archetype;
+		}
+	}
+
+	template <class Ty, class... Args> void setSharedComponent(object_id entityId, std::size_t& index, Args&&... args) { // moves the entity to the archetype of the new value
+		ETCS_PROFILE_SCOPE("etcs::World::setSharedComponent");
+		ETCS_COMPONENT_WRITE_SCOPE(m_access, "etcs::World::setSharedComponent", Ty);
+
+		auto& base = m_entities.archetype(entityId, index);
+		if (!base->contains<Ty>()) throw std::out_of_range("etcs::detail::WorldData::setSharedComponent(): A shared component was requested to be set on an entity which doesn't have that component!");
 
+		auto archetype = m_archetypes.addOrFindShared(base, lsd::typeId<Ty>(), m_archetypes.shared().pool<Ty>().insert(Ty(std::forward<Args>(args)...)));
+		if (archetype == base) return;
+
+		archetype->insertEntityFrom(entityId, *base);
+		base = archetype;
+	}
+
+	void insertRelation(object_id entityId, std::size_t& index, lsd::type_id relation, object_id target) { // retargets the relation if the entity already has it
+		ETCS_PROFILE_SCOPE("etcs::World::insertRelation");
+		ETCS_WRITE_SCOPE(m_access, "etcs::World::insertRelation");
+
+		if (!m_entities.contains(target)) throw std::out_of_range("etcs::detail::WorldData::insertRelation(): Target entity of the relation does not exist!");
+
+		auto& base = m_entities.archetype(entityId, index);
+		auto archetype = m_archetypes.addOrFindRelation(base, relation, target);
+		if (archetype == base) return;
+
+		archetype->insertEntityFrom(entityId, *base);
 		base = archetype;
 	}
+	void eraseRelation(object_id entityId, std::size_t& index, lsd::type_id relation) {
+		ETCS_PROFILE_SCOPE("etcs::World::eraseRelation");
+		ETCS_WRITE_SCOPE(m_access, "etcs::World::eraseRelation");
+
+		auto& base = m_entities.archetype(entityId, index);
+		if (base->relationTarget(relation) == nullId) throw std::out_of_range("etcs::detail::WorldData::eraseRelation(): A relation was requested to be erased from an entity which doesn't have that relation!");
+
+		auto archetype = m_archetypes.addOrFindSubsetRelation(base, relation);
+		archetype->insertEntityFrom(entityId, *base);
+
+		base = archetype;
+	}
+	void updateParent(object_id entityId, std::size_t& index) { // points ChildOf to the parent in the hierarchy, or erases it if there is none, and updates the depth of the subtree
+		auto parentId = m_entities.data(entityId, index).m_parent.id;
+
+		if (m_entities.contains(parentId)) {
+			insertRelation(entityId, index, lsd::typeId<ChildOf>(), parentId);
+
+			auto parentIndex = std::numeric_limits<std::size_t>::max();
+			m_entities.updateDepth(entityId, m_entities.data(parentId, parentIndex).m_depth + 1);
+		} else {
+			if (m_entities.archetype(entityId, index)->relationTarget(lsd::typeId<ChildOf>()) != nullId) eraseRelation(entityId, index, lsd::typeId<ChildOf>());
+
+			m_entities.updateDepth(entityId, 0);
+		}
+	}
+
+	void releaseTarget(object_id target) { // before target is erased, drops the relations of all entities which still point to it and releases the archetypes with target in their signature
+		while (auto base = m_archetypes.findRelated(target)) {
+			auto archetype = m_archetypes.addOrFindSubsetTarget(base, target);
+
+			relinkEntities(*base, archetype);
+			archetype->insertEntitiesFrom(*base);
+		}
+
+		m_archetypes.releaseRelated(target);
+	}
+
+	void nextFrame() { // nothing may iterate the world while the released archetypes are destroyed
+		ETCS_WRITE_SCOPE(m_access, "etcs::World::nextFrame");
+
+		m_archetypes.reclaim();
+		m_memory->nextFrame();
+	}
 
 	template <class Ty> bool containsComponent(object_id entityId, std::size_t& index) const {
-		return m_entities.archetype(entityId, index)->contains<Ty>();
+		if constexpr (isSparse<Ty>) return m_entities.sparse().contains<Ty>(entityId);
+		else return m_entities.archetype(entityId, index)->contains<Ty>();
 	}
 
+	shared_ptr_t<WorldMemory> m_memory; // has to be declared before anything allocating from it
+	vector_t<shared_ptr_t<WorldMemory>> m_sharedMemory;
+
 	detail::ArchetypeManager m_archetypes;
 	detail::EntityManager m_entities;
 
 	string_t m_name;
 
+	std::size_t m_slot = std::numeric_limits<std::size_t>::max(); // in the world manager, none if the world isn't registered
+	std::uint32_t m_generation = 0;
+
+	AccessGuard m_access;
+
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+	PerfCounterTable m_perfCounters;
+#endif
+
 	friend class Hasher;
 	friend class Equal;
 
@@ -72,6 +261,10 @@ private:
 	friend class ::etcs::World;
 	friend class ::etcs::Entity;
 	friend class ::etcs::EntityRange;
+	friend class ::etcs::SpawnBuffer;
+	friend class ::etcs::StagedWorld;
+	friend class ::etcs::ReadAccess;
+	friend class ::etcs::WriteAccess;
 };
 
 } // namespace detail
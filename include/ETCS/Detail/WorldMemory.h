@@ -0,0 +1,204 @@
+/*************************
+ * @file WorldMemory.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ * 
+ * @brief Memory resources owned by a world
+ * 
+ * @date 2024-10-14
+ * 
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Core.h"
+
+#include "../MemoryStats.h"
+
+#include <memory_resource>
+#include <atomic>
+#include <thread>
+
+namespace etcs {
+
+namespace detail {
+
+// bump allocator which only ever frees everything at once
+class LinearResource : public memory_resource {
+private:
+	struct Block {
+		Block* next;
+		std::size_t size;
+	};
+
+public:
+	struct Position {
+		Block* block;
+		std::byte* current;
+	};
+
+	LinearResource(memory_resource* upstream, std::size_t blockSize = 4096) : m_upstream(upstream), m_blockSize(blockSize) { }
+	LinearResource(const LinearResource&) = delete;
+	~LinearResource();
+
+	LinearResource& operator=(const LinearResource&) = delete;
+
+	void reset() noexcept; // keeps the largest block around for the next use
+	void release() noexcept;
+
+	[[nodiscard]] Position position() const noexcept {
+		return { m_blocks, m_current };
+	}
+	void rewind(Position position) noexcept { // only rewinds if no block was inserted since, the rest is freed by reset()
+		if (position.block == m_blocks) m_current = position.current;
+	}
+
+	class Scope { // rewinds the resource when leaving the scope, declare before any object allocating from it
+	public:
+		Scope(LinearResource* resource) : m_resource(resource), m_position(resource->position()) {
+			m_resource->m_scopes++;
+		}
+		Scope(const Scope&) = delete;
+		~Scope() {
+			m_resource->rewind(m_position);
+			m_resource->m_scopes--;
+		}
+
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		LinearResource* m_resource;
+		Position m_position;
+	};
+
+	[[nodiscard]] memory_resource* upstream() const noexcept {
+		return m_upstream;
+	}
+	[[nodiscard]] bool scoped() const noexcept { // if memory of an active scope may still be in use
+		return m_scopes != 0;
+	}
+
+private:
+	Block* m_blocks = nullptr;
+	std::byte* m_current = nullptr;
+	std::byte* m_end = nullptr;
+
+	memory_resource* m_upstream;
+	std::size_t m_blockSize;
+
+	std::size_t m_scopes = 0; // nested scopes which are still active
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void*, std::size_t, std::size_t) override { }
+	bool do_is_equal(const memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+
+	void insertBlock(std::size_t size);
+};
+
+
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+
+// counts all allocations passing through it
+class TrackingResource : public memory_resource {
+public:
+	TrackingResource() = default;
+	TrackingResource(const TrackingResource&) = delete;
+
+	TrackingResource& operator=(const TrackingResource&) = delete;
+
+	void upstream(memory_resource* upstream) noexcept {
+		m_upstream = upstream;
+	}
+	void nextFrame() noexcept;
+
+	[[nodiscard]] AllocationStats stats() const noexcept;
+
+private:
+	memory_resource* m_upstream = { };
+
+	std::atomic<std::size_t> m_allocations = 0;
+	std::atomic<std::size_t> m_deallocations = 0;
+	std::atomic<std::size_t> m_bytes = 0;
+	std::atomic<std::size_t> m_peakBytes = 0;
+
+	std::atomic<std::size_t> m_frameAllocations = 0;
+	std::atomic<std::size_t> m_frameBytes = 0;
+	std::atomic<std::size_t> m_previousFrameAllocations = 0;
+	std::atomic<std::size_t> m_previousFrameBytes = 0;
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(const memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
+
+#endif
+
+
+// pooled memory for the persistent data of a world, an arena for temporaries and per thread scratch memory
+class WorldMemory {
+public:
+	WorldMemory(memory_resource* upstream, memory_resource* columns = nullptr); // columns of another world, which has to outlive this one
+	WorldMemory(const WorldMemory&) = delete;
+	~WorldMemory();
+
+	WorldMemory& operator=(const WorldMemory&) = delete;
+
+	void nextFrame() noexcept;
+
+	[[nodiscard]] memory_resource* pool() noexcept {
+		return &m_pool;
+	}
+	[[nodiscard]] memory_resource* resource(AllocationTag tag) noexcept { // pool or upstream of the subsystem, tracked if enabled
+		if (tag == AllocationTag::columns && m_columns) return m_columns; // tracked by the other world
+
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+		return &m_tracking[static_cast<std::size_t>(tag)];
+#else
+		return (tag == AllocationTag::temporaries) ? m_pool.upstream_resource() : &m_pool;
+#endif
+	}
+	[[nodiscard]] LinearResource* arena() noexcept {
+		return &m_arena;
+	}
+	[[nodiscard]] LinearResource* scratch(); // memory of the calling thread, rewound at the first use of every frame outside of any scope
+	[[nodiscard]] memory_resource* upstream() const noexcept {
+		return m_pool.upstream_resource();
+	}
+
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+	[[nodiscard]] WorldAllocationStats allocationStats() const noexcept;
+#endif
+
+private:
+	struct ScratchSlot {
+		LinearResource resource;
+		std::thread::id thread;
+		std::size_t frame;
+
+		ScratchSlot* next;
+	};
+
+	std::pmr::synchronized_pool_resource m_pool; // synchronized since forked worlds may release shared columns from other threads
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+	TrackingResource m_tracking[static_cast<std::size_t>(AllocationTag::count)];
+#endif
+	LinearResource m_arena;
+	memory_resource* m_columns; // of the world this one is merged into, so its columns are relinked instead of moved
+
+	std::atomic<ScratchSlot*> m_scratch = nullptr;
+	std::atomic<std::size_t> m_frame = 0;
+
+	std::size_t m_id;
+
+	static inline std::atomic<std::size_t> m_idCounter = 0;
+
+	ScratchSlot* findOrInsertScratch();
+};
+
+} // namespace detail
+
+} // namespace etcs
@@ -15,8 +15,23 @@
 
 #include "Entity.h"
 #include "Component.h"
+#include "ComponentTraits.h"
 #include "World.h"
+#include "StagedWorld.h"
+#include "SpawnBuffer.h"
+#include "WorldAccess.h"
 #include "Prefab.h"
 #include "EntityQuery.h"
 #include "EntityRange.h"
+#include "Relation.h"
+#include "PageResource.h"
+#include "MemoryStats.h"
+#include "Profiler.h"
+#include "PerfCounters.h"
+
+#ifdef USE_COMPONENTS_EXT
+
 #include "Components/Transform.h"
+
+#endif
+
@@ -15,6 +15,7 @@
 #include "Detail/WorldData.h"
 
 #include "Component.h"
+#include "Relation.h"
 
 #include <LSD/UnorderedSparseSet.h>
  
@@ -22,8 +23,8 @@ namespace etcs {
 
 class Entity {
 private:
-	using iterator = lsd::UnorderedSparseSet<detail::EntityView, detail::EVHasher, detail::EVEqual>::iterator;
-	using const_iterator = lsd::UnorderedSparseSet<detail::EntityView, detail::EVHasher, detail::EVEqual>::const_iterator;
+	using iterator = detail::EntityData::children::iterator;
+	using const_iterator = detail::EntityData::children::const_iterator;
 
 public:
 	ETCS_DEFAULT_CONSTRUCTORS(Entity, constexpr)
@@ -31,6 +32,7 @@ public:
 	constexpr Entity(const detail::EntityView& view, Entity& parent) : m_id(view.id), m_world(parent.m_world) { }
 
 	void destroy() noexcept;
+	void destroyRecursive(); // with all descendants, instead of handing them to the parent
 	
 	constexpr void swap(Entity& other) noexcept { 
 		auto t = *this; 
@@ -49,8 +51,16 @@ public:
 	template <class Ty, class... Args> ComponentView<Ty> insertComponent(Args&&... args) const {
 		return m_world->insertComponent<Ty>(m_id, m_index, std::forward<Args>(args)...);
 	}
+	template <class Ty, class... Args> void setSharedComponent(Args&&... args) const {
+		m_world->setSharedComponent<Ty>(m_id, m_index, std::forward<Args>(args)...);
+	}
+
+	template <class Relation> void insertRelation(const Entity& target) const { // retargets the relation if the entity already has it
+		static_assert(!std::is_same_v<Relation, ChildOf>, "etcs::Entity::insertRelation(): The parent of an entity can only be changed through insertChild()!");
+		m_world->insertRelation(m_id, m_index, lsd::typeId<Relation>(), target.m_id);
+	}
 
-	Entity insertChild(const Entity& child) const;
+	Entity insertChild(const Entity& child) const; // renames child to name#id if this entity already has a child with its name
 	Entity insertChild(string_view_t name) const;
 
 	template <class Ty> Entity& erase() {
@@ -58,6 +68,12 @@ public:
 		return *this;
 	}
 
+	template <class Relation> Entity& eraseRelation() {
+		static_assert(!std::is_same_v<Relation, ChildOf>, "etcs::Entity::eraseRelation(): The parent of an entity can only be changed through insertChild()!");
+		m_world->eraseRelation(m_id, m_index, lsd::typeId<Relation>());
+		return *this;
+	}
+
 	Entity& erase(const_iterator pos);
 	Entity& erase(const_iterator first, const_iterator last);
 	Entity& erase(string_view_t name);
@@ -69,7 +85,7 @@ public:
 
 	Entity& rename(string_view_t name);
 	
-	Entity& enable();
+	Entity& enable(); // moves the entity into another archetype like inserting a component, so it has to be deferred until no query over it is iterated
 	Entity& disable();
 
 	iterator find(string_view_t name);
@@ -79,6 +95,10 @@ public:
 		return m_world->containsComponent<Ty>(m_id, m_index);
 	}
 
+	template <class Relation> bool containsRelation() const {
+		return m_world->m_entities.archetype(m_id, m_index)->relationTarget(lsd::typeId<Relation>()) != nullId;
+	}
+
 	bool contains(string_view_t name) const;
 	bool hasParent() const;
 
@@ -86,11 +106,17 @@ public:
 		return ComponentView<Ty>(m_id, m_index, &m_world->m_entities);
 	}
 
+	template <class Relation> [[nodiscard]] Entity relationTarget() const { // null entity if it doesn't have the relation
+		return Entity(m_world->m_entities.archetype(m_id, m_index)->relationTarget(lsd::typeId<Relation>()), std::numeric_limits<std::size_t>::max(), m_world);
+	}
+
 	[[nodiscard]] Entity at(string_view_t name) const;
 	[[nodiscard]] Entity operator[](string_view_t name) const;
 
 	[[nodiscard]] bool alive() const;
-	[[nodiscard]] bool active() const;
+	[[nodiscard]] bool active() const; // only if the entity itself is disabled
+	[[nodiscard]] bool activeInHierarchy() const; // false if the entity or any of its ancestors is disabled
+	[[nodiscard]] std::size_t depth() const; // number of ancestors
 
 	[[nodiscard]] bool hasComponents() const;
 	[[nodiscard]] bool hasChildren() const;
@@ -119,6 +145,7 @@ private:
 	friend class detail::BasicQueryIterator;
 	friend class World;
 	friend class EntityIterator;
+	friend class SpawnBuffer;
 };
 
 } // namespace etcs
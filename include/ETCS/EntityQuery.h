@@ -13,20 +13,37 @@
 
 #include "Detail/Core.h"
 #include "Detail/ArchetypeManager.h"
+#include "Detail/AccessGuard.h"
 #include "Entity.h"
+#include "PerfCounters.h"
 
+#include <algorithm>
+#include <limits>
 #include <tuple>
 
 namespace etcs {
 
+// query terms, resolved once per archetype when the query is constructed, except for components in sparse pools, which are checked per entity
+// if the smallest required sparse pool has fewer entities than the matched archetypes, only the entities of that pool are visited
+
+template <class Ty> struct Without { }; // only entities without the component, yields nothing
+template <class Ty> struct Optional { }; // yields a pointer to the component, which is null if the entity doesn't have it
+template <class Type, class... Types> struct AnyOf { }; // only entities with at least one of the components, yields nothing
+template <class Relation, class... TargetTypes> struct Related { }; // only entities with the relation whose target has all of the components, yields the target
+
+enum class QueryOrder {
+	archetype, // grouped by archetype, in no particular order
+	depth // parents before their children, i.e. all roots of the hierarchy first, then all of their children and so on
+};
+
 namespace detail {
 
 class BasicQueryEndIterator { };
 
 class BasicQueryIterator {
 private:
-	using archetype_it = vector_t<Archetype*>::iterator;
-	using archetype_const_it = vector_t<Archetype*>::const_iterator;
+	using archetype_it = pmr_vector_t<Archetype*>::iterator;
+	using archetype_const_it = pmr_vector_t<Archetype*>::const_iterator;
 	using entity_it = Archetype::entities::iterator;
 
 public:
@@ -36,11 +53,21 @@ public:
 
 	Entity entity();
 	template <class Ty> Ty& component() {
-		return *(*m_iterator)->m_components.at(lsd::typeId<Ty>()).template component<Ty>(m_entityIterator - (*m_iterator)->m_entities.begin());
+		if constexpr (isTag<Ty>) return TagInstance<std::remove_const_t<Ty>>::get(); // tags are never looked up
+		else if constexpr (isShared<Ty>) return (*m_iterator)->sharedComponent<std::remove_const_t<Ty>>(); // once per archetype, not per entity
+		else if constexpr (std::is_const_v<Ty>) // const access doesn't trigger a copy of memory shared with a forked world
+			return *std::as_const((*m_iterator)->m_components.at(lsd::typeId<std::remove_const_t<Ty>>())).template component<std::remove_const_t<Ty>>(m_entityIterator - (*m_iterator)->m_entities.begin());
+		else return *(*m_iterator)->m_components.at(lsd::typeId<Ty>()).template component<Ty>(m_entityIterator - (*m_iterator)->m_entities.begin());
 	}
 	template <class Ty> const Ty& component() const {
-		return *(*m_iterator)->m_components.at(lsd::typeId<Ty>()).template component<Ty>(m_entityIterator - (*m_iterator)->m_entities.begin());
+		if constexpr (isTag<Ty>) return TagInstance<Ty>::get();
+		else if constexpr (isShared<Ty>) return (*m_iterator)->sharedComponent<Ty>();
+		else return *(*m_iterator)->m_components.at(lsd::typeId<Ty>()).template component<Ty>(m_entityIterator - (*m_iterator)->m_entities.begin());
 	}
+	template <class Ty> Ty* optionalComponent(std::size_t optionalIndex); // index of the optional term in the query
+	template <class Ty> Ty& sparseComponent(std::size_t poolIndex);
+	template <class Ty> Ty* optionalSparseComponent(std::size_t poolIndex);
+	Entity relationTarget(lsd::type_id relation);
 
 	friend constexpr bool operator==(const BasicQueryIterator& first, const BasicQueryIterator& second) noexcept {
 		return first.m_iterator == second.m_iterator && first.m_entityIterator == second.m_entityIterator;
@@ -54,22 +81,36 @@ private:
 	archetype_const_it m_end = { };
 
 	entity_it m_entityIterator = { };
+	entity_it m_indexed = { }; // entity whose index in the lookup of the world was resolved last
+	std::size_t m_entityIndex = std::numeric_limits<std::size_t>::max();
 
-	std::size_t m_entityIndex = { };
+	const BasicSparsePool* m_pool = { }; // iterated instead of the archetypes if set, backwards so the sparse components of the current entity can be erased
+	std::size_t m_poolIndex = 0; // one past the current entity in the pool
 
 	BasicEntityQuery* m_query = { };
 
+#ifdef ETCS_ENABLE_PROFILING
+	std::uint64_t m_profileBegin = { }; // start of the iteration over the current archetype
+#endif
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+	PerfCounterValues m_perfBegin = { };
+#endif
+
 	BasicQueryIterator(BasicEntityQuery* query, archetype_it iterator, archetype_const_it end, entity_it entityIterator);
+	BasicQueryIterator(BasicEntityQuery* query, const BasicSparsePool& pool);
 
 	void incrementIterator();
+	void nextArchetype();
 	void skipInvalid();
+	void skipPooled(); // to the next entity of the pool in one of the archetypes of the query
+	void recordIteration(const char* event);
 
 	friend class BasicEntityQuery;
 };
 
 class BasicEntityQuery {
 public:
-	ETCS_DEFAULT_CONSTRUCTORS(BasicEntityQuery, constexpr)
+	ETCS_DEFAULT_CONSTRUCTORS(BasicEntityQuery, )
 
 	BasicQueryIterator begin();
 	BasicQueryEndIterator end() {
@@ -80,15 +121,342 @@ public:
 		return m_world;
 	}
 
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+	[[nodiscard]] const PerfCounterStats& perfCounters() const noexcept {
+		return m_perfCounters;
+	}
+#endif
+
 private:
-	vector_t<Archetype*> m_archetypes;
+	shared_ptr_t<WorldMemory> m_memory; // declared before the vectors allocated from it, so a query outliving its world still frees into a live resource
+	pmr_vector_t<Archetype*> m_archetypes;
+	pmr_vector_t<std::uint64_t> m_optionalMasks; // per archetype, one bit for every optional term which it contains
+	pmr_vector_t<BasicSparsePool*> m_sparsePools; // in the order of the sparse ids of the filter, null if a pool doesn't exist
+	pmr_vector_t<std::pair<const Archetype*, std::size_t>> m_archetypeIndices; // sorted by archetype, resolves the entities of a required pool if it is iterated instead
+	std::size_t m_sparseRequired = 0;
+	std::size_t m_sparseExcluded = 0;
+
+	QueryFilter m_filter; // only refers to the static term arrays of the query, so the archetypes can be collected again
+	RelationFilter m_target;
+	QueryOrder m_order = QueryOrder::archetype;
+	std::size_t m_generation = 0; // of the archetypes of the world when they were collected
+
 	WorldData* m_world = { };
 
-	BasicEntityQuery(WorldData* world, const vector_t<lsd::type_id>& typeIds);
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+	PerfCounterStats m_perfCounters; // iteration of only this query
+#endif
+
+	BasicEntityQuery(WorldData* world, const QueryFilter& filter, QueryOrder order = QueryOrder::archetype, const RelationFilter& target = { }); // target restricts the query to the entities of a single relation target
+
+	void collect();
+	void refresh(); // collects the archetypes again if some of them were destroyed since
+	[[nodiscard]] const BasicSparsePool* smallerPool() const noexcept; // smallest required pool, if it has fewer entities than the archetypes
+	void sortByDepth();
+	void eraseDisabled();
+
+	template <class Ty> void insertComponentAll(const Ty& component);
+	template <class Ty> void eraseComponentAll();
+	bool matchingEntities(const Archetype& archetype, pmr_vector_t<object_id>& entityIds) const; // true if all entities of the archetype match the sparse terms
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+	void checkWrites(span_t<const ComponentAccess> components) const; // against the active read accesses of the world
+#endif
 
 	void loopAndAddArchetype(Archetype* archetype);
 
+	[[nodiscard]] bool matchesRelation(const Archetype& archetype, const RelationFilter& filter) const;
+	[[nodiscard]] bool matchesSparse(object_id entityId) const noexcept {
+		for (std::size_t i = 0; i < m_sparseRequired; i++) 
+			if (!m_sparsePools[i]->contains(entityId)) return false;
+		for (std::size_t i = m_sparseRequired; i < m_sparseRequired + m_sparseExcluded; i++) 
+			if (m_sparsePools[i] && m_sparsePools[i]->contains(entityId)) return false;
+
+		return true;
+	}
+
+	friend class BasicQueryIterator;
 	template <class, class...> friend class ::etcs::EntityQuery;
+	friend class ::etcs::World;
+};
+
+template <class Ty> void BasicEntityQuery::insertComponentAll(const Ty& component) { // whole archetypes are moved at once, only entities filtered by sparse terms are moved one by one
+	refresh();
+
+	for (auto archetype : m_archetypes) {
+		if (m_sparsePools.empty()) {
+			m_world->insertComponentAll<Ty>(archetype, component);
+			continue;
+		}
+
+		auto scratch = m_world->m_memory->scratch();
+		LinearResource::Scope scope(scratch);
+
+		pmr_vector_t<object_id> entityIds(scratch);
+		if (matchingEntities(*archetype, entityIds)) m_world->insertComponentAll<Ty>(archetype, component);
+		else {
+			for (auto id : entityIds) {
+				auto index = std::numeric_limits<std::size_t>::max();
+				if (!m_world->containsComponent<Ty>(id, index)) m_world->insertComponent<Ty>(id, index, component);
+			}
+		}
+	}
+}
+template <class Ty> void BasicEntityQuery::eraseComponentAll() {
+	refresh();
+
+	for (auto archetype : m_archetypes) {
+		if (m_sparsePools.empty()) {
+			m_world->eraseComponentAll<Ty>(archetype);
+			continue;
+		}
+
+		auto scratch = m_world->m_memory->scratch();
+		LinearResource::Scope scope(scratch);
+
+		pmr_vector_t<object_id> entityIds(scratch);
+		if (matchingEntities(*archetype, entityIds)) m_world->eraseComponentAll<Ty>(archetype);
+		else {
+			for (auto id : entityIds) {
+				auto index = std::numeric_limits<std::size_t>::max();
+				if (m_world->containsComponent<Ty>(id, index)) m_world->eraseComponent<Ty>(id, index);
+			}
+		}
+	}
+}
+
+template <class Ty> Ty* BasicQueryIterator::optionalComponent(std::size_t optionalIndex) {
+	if (m_query->m_optionalMasks[m_iterator - m_query->m_archetypes.begin()] & (std::uint64_t(1) << optionalIndex)) return &component<Ty>();
+	else return nullptr;
+}
+template <class Ty> Ty& BasicQueryIterator::sparseComponent(std::size_t poolIndex) {
+	return static_cast<SparsePool<std::remove_const_t<Ty>>*>(m_query->m_sparsePools[poolIndex])->get(*m_entityIterator);
+}
+template <class Ty> Ty* BasicQueryIterator::optionalSparseComponent(std::size_t poolIndex) {
+	if (auto pool = m_query->m_sparsePools[poolIndex]; pool && pool->contains(*m_entityIterator)) return &sparseComponent<Ty>(poolIndex);
+	else return nullptr;
+}
+
+
+enum class QueryTermKind {
+	entity,
+	required,
+	excluded,
+	anyOf,
+	optional,
+	relation,
+	sparse,
+	sparseExcluded,
+	sparseOptional
+};
+
+template <class Ty> struct QueryTerm {
+	static_assert(!isShared<Ty> || std::is_const_v<Ty>, "etcs::detail::QueryTerm: Shared components can only be queried as const!");
+
+	using value_type = std::tuple<Ty&>;
+
+	static constexpr auto kind = isSparse<Ty> ? QueryTermKind::sparse : QueryTermKind::required;
+	static constexpr std::size_t idCount = 1;
+	static constexpr bool writable = !std::is_const_v<Ty>;
+	static constexpr std::size_t accessCount = 1;
+
+	template <class Array> static constexpr void typeIds(Array& ids, std::size_t& index) {
+		ids[index++] = lsd::typeId<std::remove_const_t<Ty>>();
+	}
+	template <class Array> static constexpr void accesses(Array& components, std::size_t& index) {
+		components[index++] = componentAccess<Ty>();
+	}
+	template <std::size_t Index> static value_type value(BasicQueryIterator& iterator) {
+		if constexpr (isSparse<Ty>) return value_type { iterator.sparseComponent<Ty>(Index) };
+		else return value_type { iterator.component<Ty>() };
+	}
+};
+template <class Ty> requires(std::is_same_v<Entity, std::remove_const_t<Ty>>) struct QueryTerm<Ty> {
+	using value_type = std::tuple<Ty>;
+
+	static constexpr auto kind = QueryTermKind::entity;
+	static constexpr std::size_t idCount = 0;
+	static constexpr bool writable = false;
+	static constexpr std::size_t accessCount = 0;
+
+	template <class Array> static constexpr void typeIds(Array&, std::size_t&) { }
+	template <std::size_t> static value_type value(BasicQueryIterator& iterator) {
+		return value_type { iterator.entity() };
+	}
+};
+template <class Ty> struct QueryTerm<Without<Ty>> {
+	using value_type = std::tuple<>;
+
+	static constexpr auto kind = isSparse<Ty> ? QueryTermKind::sparseExcluded : QueryTermKind::excluded;
+	static constexpr std::size_t idCount = 1;
+	static constexpr bool writable = false;
+	static constexpr std::size_t accessCount = 0; // only the signatures of the archetypes are read
+
+	template <class Array> static constexpr void typeIds(Array& ids, std::size_t& index) {
+		ids[index++] = lsd::typeId<std::remove_const_t<Ty>>();
+	}
+	template <std::size_t> static value_type value(BasicQueryIterator&) {
+		return { };
+	}
+};
+template <class Ty> struct QueryTerm<Optional<Ty>> {
+	static_assert(!isShared<Ty> || std::is_const_v<Ty>, "etcs::detail::QueryTerm: Shared components can only be queried as const!");
+
+	using value_type = std::tuple<Ty*>;
+
+	static constexpr auto kind = isSparse<Ty> ? QueryTermKind::sparseOptional : QueryTermKind::optional;
+	static constexpr std::size_t idCount = 1;
+	static constexpr bool writable = !std::is_const_v<Ty>;
+	static constexpr std::size_t accessCount = 1;
+
+	template <class Array> static constexpr void typeIds(Array& ids, std::size_t& index) {
+		ids[index++] = lsd::typeId<std::remove_const_t<Ty>>();
+	}
+	template <class Array> static constexpr void accesses(Array& components, std::size_t& index) {
+		components[index++] = componentAccess<Ty>();
+	}
+	template <std::size_t Index> static value_type value(BasicQueryIterator& iterator) {
+		if constexpr (isSparse<Ty>) return value_type { iterator.optionalSparseComponent<Ty>(Index) };
+		else return value_type { iterator.optionalComponent<Ty>(Index) };
+	}
+};
+template <class Relation, class... TargetTypes> struct QueryTerm<Related<Relation, TargetTypes...>> {
+	static_assert((!isSparse<TargetTypes> && ...), "etcs::detail::QueryTerm: Components stored in sparse pools can't be required from the target of a relation!");
+
+	using value_type = std::tuple<Entity>;
+
+	static constexpr auto kind = QueryTermKind::relation;
+	static constexpr std::size_t idCount = 1;
+	static constexpr bool writable = false;
+	static constexpr std::size_t accessCount = 0;
+
+	static constexpr array_t<lsd::type_id, std::max<std::size_t>(sizeof...(TargetTypes), 1)> targetIds { lsd::typeId<std::remove_const_t<TargetTypes>>()... };
+
+	template <class Array> static constexpr void typeIds(Array& ids, std::size_t& index) { // the relation is resolved through the archetype lookup like any required component
+		ids[index++] = lsd::typeId<Relation>();
+	}
+	static constexpr RelationFilter relationFilter() noexcept {
+		return RelationFilter { lsd::typeId<Relation>(), span_t<const lsd::type_id>(targetIds).first(sizeof...(TargetTypes)) };
+	}
+	template <std::size_t> static value_type value(BasicQueryIterator& iterator) {
+		return value_type { iterator.relationTarget(lsd::typeId<Relation>()) };
+	}
+};
+template <class... Types> struct QueryTerm<AnyOf<Types...>> {
+	static_assert((!isSparse<Types> && ...), "etcs::detail::QueryTerm: Components stored in sparse pools can't be alternatives of an any of term!");
+
+	using value_type = std::tuple<>;
+
+	static constexpr auto kind = QueryTermKind::anyOf;
+	static constexpr std::size_t idCount = sizeof...(Types);
+	static constexpr bool writable = false;
+	static constexpr std::size_t accessCount = 0;
+
+	template <class Array> static constexpr void typeIds(Array& ids, std::size_t& index) {
+		((ids[index++] = lsd::typeId<std::remove_const_t<Types>>()), ...);
+	}
+	template <std::size_t> static value_type value(BasicQueryIterator&) {
+		return { };
+	}
+};
+
+// type ids of all terms of a query sorted by their kind, computed at compile time so constructing a query doesn't allocate them
+template <class... Terms> class QueryTerms {
+public:
+	using value_type = decltype(std::tuple_cat(std::declval<typename QueryTerm<Terms>::value_type>()...));
+
+	static constexpr std::size_t count(QueryTermKind kind) noexcept {
+		return ((QueryTerm<Terms>::kind == kind ? QueryTerm<Terms>::idCount : 0) + ... + 0);
+	}
+	static constexpr std::size_t termCount(QueryTermKind kind) noexcept {
+		return ((QueryTerm<Terms>::kind == kind ? 1 : 0) + ... + 0);
+	}
+	static constexpr std::size_t index(std::size_t term) noexcept { // bit of an optional term in the masks of the query or index of the sparse pool of a term
+		constexpr QueryTermKind kinds[] = { QueryTerm<Terms>::kind... };
+
+		std::size_t index = std::count(kinds, kinds + term, kinds[term]);
+		if (kinds[term] == QueryTermKind::sparseExcluded) index += termCount(QueryTermKind::sparse);
+		else if (kinds[term] == QueryTermKind::sparseOptional) index += termCount(QueryTermKind::sparse) + termCount(QueryTermKind::sparseExcluded);
+
+		return index;
+	}
+
+	static_assert(termCount(QueryTermKind::optional) <= 64, "etcs::detail::QueryTerms: A query can't have more than 64 optional terms!");
+
+	static constexpr std::size_t sparseCount = count(QueryTermKind::sparse) + count(QueryTermKind::sparseExcluded) + count(QueryTermKind::sparseOptional);
+
+	static constexpr auto typeIds = [] {
+		array_t<lsd::type_id, std::max<std::size_t>(count(QueryTermKind::required) + count(QueryTermKind::relation) + count(QueryTermKind::excluded) + count(QueryTermKind::anyOf) + count(QueryTermKind::optional) + sparseCount, 1)> ids { };
+
+		std::size_t index = 0;
+		for (auto kind : { 
+			QueryTermKind::required, QueryTermKind::relation, QueryTermKind::excluded, QueryTermKind::anyOf, QueryTermKind::optional, 
+			QueryTermKind::sparse, QueryTermKind::sparseExcluded, QueryTermKind::sparseOptional 
+		}) ((QueryTerm<Terms>::kind == kind ? QueryTerm<Terms>::typeIds(ids, index) : void()), ...);
+
+		return ids;
+	}();
+	static constexpr auto anyOfEnds = [] {
+		array_t<std::size_t, std::max<std::size_t>(termCount(QueryTermKind::anyOf), 1)> ends { };
+
+		std::size_t index = 0, end = 0;
+		((QueryTerm<Terms>::kind == QueryTermKind::anyOf ? void(ends[index++] = (end += QueryTerm<Terms>::idCount)) : void()), ...);
+
+		return ends;
+	}();
+	static constexpr auto sparseWritable = [] {
+		array_t<bool, std::max<std::size_t>(sparseCount, 1)> writable { };
+
+		std::size_t index = 0;
+		for (auto kind : { QueryTermKind::sparse, QueryTermKind::sparseExcluded, QueryTermKind::sparseOptional }) 
+			((QueryTerm<Terms>::kind == kind ? void(writable[index++] = QueryTerm<Terms>::writable) : void()), ...);
+
+		return writable;
+	}();
+
+	static constexpr bool writable = (QueryTerm<Terms>::writable || ...);
+
+	static constexpr auto accesses = [] { // components whose data the query reads or writes, for detecting conflicting accesses
+		array_t<ComponentAccess, (QueryTerm<Terms>::accessCount + ... + 0)> components { };
+
+		std::size_t index = 0;
+		([&] {
+			if constexpr (QueryTerm<Terms>::accessCount != 0) QueryTerm<Terms>::accesses(components, index);
+		}(), ...);
+
+		return components;
+	}();
+
+	static constexpr auto relations = [] {
+		array_t<RelationFilter, std::max<std::size_t>(termCount(QueryTermKind::relation), 1)> relations { };
+
+		std::size_t index = 0;
+		([&] {
+			if constexpr (QueryTerm<Terms>::kind == QueryTermKind::relation) relations[index++] = QueryTerm<Terms>::relationFilter();
+		}(), ...);
+
+		return relations;
+	}();
+
+	static constexpr QueryFilter filter() noexcept {
+		auto ids = span_t<const lsd::type_id>(typeIds);
+		auto excludedBegin = count(QueryTermKind::required) + count(QueryTermKind::relation);
+		auto anyOfBegin = excludedBegin + count(QueryTermKind::excluded);
+		auto optionalBegin = anyOfBegin + count(QueryTermKind::anyOf);
+		auto sparseBegin = optionalBegin + count(QueryTermKind::optional);
+
+		return QueryFilter {
+			ids.first(excludedBegin),
+			ids.subspan(excludedBegin, anyOfBegin - excludedBegin),
+			ids.subspan(anyOfBegin, optionalBegin - anyOfBegin),
+			span_t<const std::size_t>(anyOfEnds).first(termCount(QueryTermKind::anyOf)),
+			ids.subspan(optionalBegin, sparseBegin - optionalBegin),
+			ids.subspan(sparseBegin, sparseCount),
+			span_t<const bool>(sparseWritable).first(sparseCount),
+			count(QueryTermKind::sparse),
+			count(QueryTermKind::sparseExcluded),
+			span_t<const RelationFilter>(relations).first(termCount(QueryTermKind::relation))
+		};
+	}
 };
 
 } // namespace detail
@@ -96,11 +464,8 @@ private:
 
 template <class Type, class... Types> class QueryIterator {
 public:
-	using value_type = std::conditional_t<
-		std::is_same_v<Entity, std::remove_const_t<Type>>, 
-		std::tuple<Type, Types&...>, 
-		std::tuple<Type&, Types&...>
-	>;
+	using terms = detail::QueryTerms<Type, Types...>;
+	using value_type = typename terms::value_type;
 
 	ETCS_DEFAULT_CONSTRUCTORS(QueryIterator, constexpr)
 
@@ -112,9 +477,7 @@ public:
 	}
 
 	value_type operator*() {
-		if constexpr (std::is_same_v<Entity, std::remove_const_t<Type>>) 
-			return value_type { m_iterator.entity(), m_iterator.component<std::remove_const_t<Types>>()... };
-		else return value_type { m_iterator.component<std::remove_const_t<Type>>(), m_iterator.component<std::remove_const_t<Types>>()... };
+		return values(std::index_sequence_for<Types...>());
 	}
 
 	QueryIterator& operator++() {
@@ -139,6 +502,10 @@ private:
 
 	QueryIterator(detail::BasicQueryIterator&& iterator) : m_iterator(iterator) { }
 
+	template <std::size_t... Indices> value_type values(std::index_sequence<Indices...>) {
+		return std::tuple_cat(detail::QueryTerm<Type>::template value<terms::index(0)>(m_iterator), detail::QueryTerm<Types>::template value<terms::index(Indices + 1)>(m_iterator)...);
+	}
+
 	template <class, class...> friend class EntityQuery;
 };
 
@@ -155,16 +522,20 @@ public:
 		return detail::BasicQueryEndIterator();
 	}
 
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+	[[nodiscard]] const PerfCounterStats& perfCounters() const noexcept { // hardware counters of all iterations over this query
+		return m_entityQuery.perfCounters();
+	}
+#endif
+
 private:
 	detail::BasicEntityQuery m_entityQuery;
 
-	EntityQuery(detail::WorldData* world) requires(!std::is_same_v<Entity, std::remove_const_t<Type>>) : 
-		m_entityQuery(world, { 
-			lsd::typeId<std::remove_const_t<Type>>(), 
-			lsd::typeId<std::remove_const_t<Types>>()...
-		}) { }
-	EntityQuery(detail::WorldData* world) requires(std::is_same_v<Entity, std::remove_const_t<Type>>) : 
-		m_entityQuery(world, { lsd::typeId<std::remove_const_t<Types>>()... }) { }
+	EntityQuery(detail::WorldData* world, QueryOrder order = QueryOrder::archetype, const detail::RelationFilter& target = { }) : m_entityQuery(world, detail::QueryTerms<Type, Types...>::filter(), order, target) {
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+		if constexpr (detail::QueryTerms<Type, Types...>::writable) m_entityQuery.checkWrites(detail::QueryTerms<Type, Types...>::accesses);
+#endif
+	}
 
 	friend class World;
 };
@@ -0,0 +1,147 @@
+/*************************
+ * @file MemoryStats.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Memory statistics of a world
+ *
+ * @date 2024-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Detail/Core.h"
+
+#include <LSD/Utility.h>
+#include <LSD/UnorderedSparseSet.h>
+#include <LSD/UnorderedSparseMap.h>
+
+namespace etcs {
+
+// all sizes are in bytes, hash table buckets are estimated as one list head per bucket and one list node per element
+
+struct ColumnMemoryStats {
+	lsd::type_id type = { };
+
+	std::size_t elementSize = 0; // 0 for empty components, which don't store any data
+	std::size_t size = 0;
+	std::size_t capacity = 0;
+
+	bool shared = false; // shared with a forked world until either of them writes to it
+
+	[[nodiscard]] std::size_t usedBytes() const noexcept {
+		return size * elementSize;
+	}
+	[[nodiscard]] std::size_t reservedBytes() const noexcept {
+		return capacity * elementSize;
+	}
+};
+
+struct ArchetypeMemoryStats {
+	std::size_t hash = 0;
+	std::size_t entities = 0;
+
+	vector_t<ColumnMemoryStats> columns;
+	std::size_t tags = 0; // number of tags, which don't have a column
+	std::size_t sharedComponents = 0; // number of shared components, whose values are stored once per world
+	std::size_t relations = 0; // number of relations, whose targets are part of the signature
+
+	std::size_t usedBytes = 0; // columns and entity ids actually in use
+	std::size_t reservedBytes = 0; // allocated capacity of the columns, the entity set, the column table and the tag set
+	std::size_t bucketBytes = 0; // buckets of the entity set, the column table and the tag set
+
+	[[nodiscard]] std::size_t totalBytes() const noexcept {
+		return reservedBytes + bucketBytes;
+	}
+};
+
+struct EntityMemoryStats {
+	std::size_t entities = 0;
+
+	std::size_t lookupBytes = 0; // elements of the entity table
+	std::size_t lookupBucketBytes = 0;
+	std::size_t nameBytes = 0; // all names, which are always allocated out of line
+	std::size_t childrenBytes = 0; // elements of all children sets
+	std::size_t childrenBucketBytes = 0;
+	std::size_t unusedIdBytes = 0; // capacity of the list of ids to be reused
+
+	[[nodiscard]] std::size_t totalBytes() const noexcept {
+		return lookupBytes + lookupBucketBytes + nameBytes + childrenBytes + childrenBucketBytes + unusedIdBytes;
+	}
+};
+
+struct WorldMemoryStats {
+	vector_t<ArchetypeMemoryStats> archetypes;
+	EntityMemoryStats entities;
+
+	std::size_t archetypeTableBytes = 0; // the archetype set and the per type archetype lookup, including their buckets
+
+	vector_t<ColumnMemoryStats> sparsePools; // components stored outside of the archetypes
+	std::size_t sparseBytes = 0; // allocated capacity of all sparse pools, including their indices and the pool table
+	std::size_t sharedBytes = 0; // all deduplicated values of shared components and their pool table
+
+	std::size_t usedBytes = 0; // over all archetypes
+	std::size_t reservedBytes = 0; // over all archetypes
+	std::size_t bucketBytes = 0; // over all archetypes
+
+	[[nodiscard]] std::size_t totalBytes() const noexcept {
+		return reservedBytes + bucketBytes + archetypeTableBytes + sparseBytes + sharedBytes + entities.totalBytes();
+	}
+};
+
+// subsystems whose allocations are tracked separately with ETCS_ENABLE_ALLOCATION_TRACKING
+enum class AllocationTag {
+	columns, // component columns, signatures and entity sets of the archetypes, the archetype tables and the sparse and shared pools
+	entities, // entity table and list of reusable ids
+	names,
+	children,
+	queries, // archetype lists of queries
+	temporaries, // blocks of the scratch memory and the arena used for prefab instantiation
+
+	count
+};
+
+struct AllocationStats {
+	std::size_t allocations = 0;
+	std::size_t deallocations = 0;
+	std::size_t bytes = 0; // currently allocated
+	std::size_t peakBytes = 0;
+
+	std::size_t frameAllocations = 0; // since the last call to World::nextFrame()
+	std::size_t frameBytes = 0;
+	std::size_t previousFrameAllocations = 0; // during the last complete frame
+	std::size_t previousFrameBytes = 0;
+};
+
+using WorldAllocationStats = array_t<AllocationStats, static_cast<std::size_t>(AllocationTag::count)>;
+
+namespace detail {
+
+template <class Ty, class Alloc> [[nodiscard]] constexpr std::size_t reservedBytes(const vector_t<Ty, Alloc>& container) noexcept {
+	return container.capacity() * sizeof(Ty);
+}
+
+// the sparse sets and maps don't expose the capacity of their dense array, so only its elements are counted
+template <class Key, class Hash, class Equal, class Alloc> [[nodiscard]] constexpr std::size_t reservedBytes(const lsd::UnorderedSparseSet<Key, Hash, Equal, Alloc>& container) noexcept {
+	return container.size() * sizeof(Key);
+}
+template <class Key, class Ty, class Hash, class Equal, class Alloc> [[nodiscard]] constexpr std::size_t reservedBytes(const lsd::UnorderedSparseMap<Key, Ty, Hash, Equal, Alloc>& container) noexcept {
+	return container.size() * sizeof(typename lsd::UnorderedSparseMap<Key, Ty, Hash, Equal, Alloc>::value_type);
+}
+
+// every bucket is a list of indices into the dense array, with one list node per element
+template <class Container> [[nodiscard]] constexpr std::size_t sparseBucketBytes(const Container& container) noexcept {
+	return container.bucketCount() * sizeof(typename Container::bucket_list) + container.size() * (sizeof(typename Container::bucket_type) + sizeof(void*));
+}
+
+template <class Key, class Hash, class Equal, class Alloc> [[nodiscard]] constexpr std::size_t bucketBytes(const lsd::UnorderedSparseSet<Key, Hash, Equal, Alloc>& container) noexcept {
+	return sparseBucketBytes(container);
+}
+template <class Key, class Ty, class Hash, class Equal, class Alloc> [[nodiscard]] constexpr std::size_t bucketBytes(const lsd::UnorderedSparseMap<Key, Ty, Hash, Equal, Alloc>& container) noexcept {
+	return sparseBucketBytes(container);
+}
+
+} // namespace detail
+
+} // namespace etcs
@@ -0,0 +1,84 @@
+/*************************
+ * @file PageResource.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Page based upstream memory for large worlds
+ *
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Detail/Core.h"
+
+#include <mutex>
+
+namespace etcs {
+
+// maps memory directly from the operating system, intended as the upstream resource of a world with a lot of entities
+// large allocations (i.e. the component columns) get their own mapping, small ones are carved out of shared chunks and reused through free lists
+// mappings can be backed by transparent huge pages and pinned to a NUMA node
+// on systems other than linux, chunks and large allocations are simply allocated with operator new
+class PageResource : public memory_resource {
+public:
+	static constexpr std::size_t pageSize = 4096;
+	static constexpr std::size_t hugePageSize = 2 * 1024 * 1024;
+
+	static constexpr std::size_t minBlockSize = 64; // small allocations are rounded up to a power of two of at least this size
+
+	static constexpr int anyNode = -1;
+
+	PageResource(bool hugePages = true, int node = anyNode, bool strictNode = false) : m_hugePages(hugePages), m_node(node), m_strictNode(strictNode) { }
+	PageResource(const PageResource&) = delete;
+	~PageResource(); // unmaps all chunks, every allocation has to be returned before
+
+	PageResource& operator=(const PageResource&) = delete;
+
+	[[nodiscard]] bool hugePages() const noexcept {
+		return m_hugePages;
+	}
+	[[nodiscard]] int node() const noexcept {
+		return m_node;
+	}
+
+	[[nodiscard]] static int currentNode() noexcept; // NUMA node of the calling thread, anyNode if it can't be determined
+
+	[[nodiscard]] std::size_t chunkSize() const noexcept { // size of the mappings small allocations are carved from
+		return m_hugePages ? hugePageSize : 64 * pageSize;
+	}
+	[[nodiscard]] std::size_t chunkCount() const noexcept;
+
+private:
+	static constexpr std::size_t blockClassCount = 13; // powers of two from minBlockSize up to an eighth of a huge page
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	bool m_hugePages;
+	int m_node;
+	bool m_strictNode; // if set, allocations fail instead of falling back to other nodes
+
+	mutable std::mutex m_mutex; // shared by all worlds using the resource
+	FreeBlock* m_freeBlocks[blockClassCount] = { };
+	FreeBlock* m_chunks = nullptr; // the first block of every chunk links it to the next one
+	std::byte* m_current = nullptr; // rest of the newest chunk which hasn't been carved yet
+	std::byte* m_end = nullptr;
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(const memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+
+	[[nodiscard]] std::size_t mappingSize(std::size_t bytes) const noexcept;
+	[[nodiscard]] std::size_t blockSize(std::size_t bytes, std::size_t alignment) const noexcept; // 0 if the allocation gets its own mapping
+
+	void* map(std::size_t size, std::size_t alignment);
+	void unmap(void* p, std::size_t size, std::size_t alignment) noexcept;
+	void* carve(std::size_t size); // the mutex has to be locked
+};
+
+} // namespace etcs
@@ -0,0 +1,181 @@
+/*************************
+ * @file PerfCounters.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Hardware performance counters attributed to ECS operations
+ *
+ * @date 2024-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Detail/Core.h"
+
+#include <atomic>
+
+namespace etcs {
+
+// counters of the user space code of the calling thread, all zero if they aren't supported
+struct PerfCounterValues {
+	std::uint64_t instructions = 0;
+	std::uint64_t cacheMisses = 0;
+	std::uint64_t branchMisses = 0;
+
+	PerfCounterValues& operator+=(const PerfCounterValues& other) noexcept {
+		instructions += other.instructions;
+		cacheMisses += other.cacheMisses;
+		branchMisses += other.branchMisses;
+		return *this;
+	}
+	friend PerfCounterValues operator-(const PerfCounterValues& first, const PerfCounterValues& second) noexcept {
+		return { first.instructions - second.instructions, first.cacheMisses - second.cacheMisses, first.branchMisses - second.branchMisses };
+	}
+	friend PerfCounterValues operator*(const PerfCounterValues& values, std::uint64_t factor) noexcept {
+		return { values.instructions * factor, values.cacheMisses * factor, values.branchMisses * factor };
+	}
+};
+
+struct PerfCounterStats {
+	std::uint64_t calls = 0;
+	PerfCounterValues values;
+};
+
+enum class PerfOperation {
+	queryConstruction,
+	queryIteration, // counted per iterated archetype
+	componentInsertion,
+	componentErasure,
+	entityLookup, // of children by name
+	prefabInstantiation,
+	entityData, // lookups by id outside of all other operations, estimated from a sample of them
+
+	count
+};
+
+using WorldPerfCounters = array_t<PerfCounterStats, static_cast<std::size_t>(PerfOperation::count)>;
+
+// false if the counters can't be opened, i.e. outside of linux or if perf_event_paranoid forbids it
+[[nodiscard]] bool perfCountersAvailable();
+
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+
+namespace detail {
+
+[[nodiscard]] PerfCounterValues readPerfCounters() noexcept;
+
+// counters of a world, added to from every thread operating on it
+class PerfCounterTable {
+public:
+	void add(PerfOperation operation, const PerfCounterValues& values, std::uint64_t calls = 1) noexcept {
+		auto& counters = m_counters[static_cast<std::size_t>(operation)];
+
+		counters.calls.fetch_add(calls, std::memory_order_relaxed);
+		counters.instructions.fetch_add(values.instructions, std::memory_order_relaxed);
+		counters.cacheMisses.fetch_add(values.cacheMisses, std::memory_order_relaxed);
+		counters.branchMisses.fetch_add(values.branchMisses, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] WorldPerfCounters snapshot() const noexcept {
+		WorldPerfCounters result;
+
+		for (std::size_t i = 0; i < result.size(); i++) {
+			result[i].calls = m_counters[i].calls.load(std::memory_order_relaxed);
+			result[i].values = {
+				m_counters[i].instructions.load(std::memory_order_relaxed),
+				m_counters[i].cacheMisses.load(std::memory_order_relaxed),
+				m_counters[i].branchMisses.load(std::memory_order_relaxed)
+			};
+		}
+
+		return result;
+	}
+	void reset() noexcept {
+		for (auto& counters : m_counters) {
+			counters.calls.store(0, std::memory_order_relaxed);
+			counters.instructions.store(0, std::memory_order_relaxed);
+			counters.cacheMisses.store(0, std::memory_order_relaxed);
+			counters.branchMisses.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct Counters {
+		std::atomic<std::uint64_t> calls = 0;
+		std::atomic<std::uint64_t> instructions = 0;
+		std::atomic<std::uint64_t> cacheMisses = 0;
+		std::atomic<std::uint64_t> branchMisses = 0;
+	};
+
+	array_t<Counters, static_cast<std::size_t>(PerfOperation::count)> m_counters;
+};
+
+[[nodiscard]] std::size_t& perfScopeDepth() noexcept; // of the scopes active on the calling thread
+[[nodiscard]] bool perfSampleDue() noexcept; // for every perfSampleRate-th call on the calling thread outside of any scope
+
+inline constexpr std::uint64_t perfSampleRate = 256;
+
+// only the outermost scope of a thread is counted, so the operations nested inside of it aren't attributed twice
+class PerfScope {
+public:
+	PerfScope(PerfCounterTable& table, PerfOperation operation) noexcept : m_table(table), m_operation(operation), m_outermost(perfScopeDepth()++ == 0) {
+		if (m_outermost) m_begin = readPerfCounters();
+	}
+	PerfScope(const PerfScope&) = delete;
+	~PerfScope() {
+		if (m_outermost) m_table.add(m_operation, readPerfCounters() - m_begin);
+		perfScopeDepth()--;
+	}
+
+	PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+	PerfCounterTable& m_table;
+	PerfOperation m_operation;
+	bool m_outermost;
+	PerfCounterValues m_begin;
+};
+
+// for paths too hot to read the counters every time, only one of every perfSampleRate calls is measured and counted for all of them
+class PerfSample {
+public:
+	PerfSample(PerfCounterTable& table, PerfOperation operation) noexcept : m_table(table), m_operation(operation), m_sampled(perfSampleDue()) {
+		if (m_sampled) {
+			perfScopeDepth()++;
+			m_begin = readPerfCounters();
+		}
+	}
+	PerfSample(const PerfSample&) = delete;
+	~PerfSample() {
+		if (!m_sampled) return;
+
+		m_table.add(m_operation, (readPerfCounters() - m_begin) * perfSampleRate, perfSampleRate);
+		perfScopeDepth()--;
+	}
+
+	PerfSample& operator=(const PerfSample&) = delete;
+
+private:
+	PerfCounterTable& m_table;
+	PerfOperation m_operation;
+	bool m_sampled;
+	PerfCounterValues m_begin;
+};
+
+} // namespace detail
+
+#define ETCS_PERF_CONCAT_IMPL(first, second) first##second
+#define ETCS_PERF_CONCAT(first, second) ETCS_PERF_CONCAT_IMPL(first, second)
+
+#define ETCS_PERF_SCOPE(table, operation) ::etcs::detail::PerfScope ETCS_PERF_CONCAT(etcsPerfScope, __LINE__)(table, ::etcs::PerfOperation::operation)
+#define ETCS_PERF_SAMPLE(table, operation) ::etcs::detail::PerfSample ETCS_PERF_CONCAT(etcsPerfSample, __LINE__)(table, ::etcs::PerfOperation::operation)
+
+#else
+
+#define ETCS_PERF_SCOPE(table, operation) ((void)0)
+#define ETCS_PERF_SAMPLE(table, operation) ((void)0)
+
+#endif
+
+} // namespace etcs
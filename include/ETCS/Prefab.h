@@ -10,10 +10,85 @@
 
 #pragma once
 
+#include "Detail/Core.h"
+#include "Detail/ArchetypeManager.h"
+
+#include <stdexcept>
+
 namespace etcs {
 
-template <class> class Prefab {
+class Prefab {
+private:
+	using prefab_handle = unique_ptr_t<Prefab>;
+
+public:
+	Prefab(string_view_t name = { }) : m_name(name), m_archetype(unique_ptr_t<detail::Archetype>::create()) {
+		m_archetype->insertEntity(0); // a prefab is a single row in its own archetype
+	}
+	Prefab(Prefab&&) = default;
+	Prefab& operator=(Prefab&&) = default;
+
+	template <class Ty, class... Args> Prefab& insertComponent(Args&&... args) {
+		static_assert(!detail::isSparse<Ty>, "etcs::Prefab::insertComponent(): Components stored in sparse pools can't be part of a prefab!");
+		static_assert(!detail::isShared<Ty>, "etcs::Prefab::insertComponent(): Shared components can't be part of a prefab!");
+
+		if (m_archetype->contains<Ty>()) throw std::out_of_range("etcs::Prefab::insertComponent(): A component was requested to be inserted into a prefab which already has that component!");
+
+		auto archetype = unique_ptr_t<detail::Archetype>::create(m_archetype->createSuper<Ty>(m_archetype->superHash(lsd::typeId<Ty>())));
+		archetype->template insertEntityFromSub<Ty>(0, *m_archetype, std::forward<Args>(args)...);
+		m_archetype = std::move(archetype);
+
+		return *this;
+	}
+	template <class Ty> Prefab& eraseComponent() {
+		if (!m_archetype->contains<Ty>()) throw std::out_of_range("etcs::Prefab::eraseComponent(): A component was requested to be erased from a prefab which doesn't have that component!");
+
+		auto archetype = unique_ptr_t<detail::Archetype>::create(m_archetype->createSub<Ty>(m_archetype->subHash(lsd::typeId<Ty>())));
+		archetype->template insertEntityFromSuper<Ty>(0, *m_archetype);
+		m_archetype = std::move(archetype);
+
+		return *this;
+	}
+
+	Prefab& insertChild(string_view_t name) {
+		for (auto& child : m_children) if (child->m_name == name) return *child;
+		return *m_children.emplace_back(prefab_handle::create(name));
+	}
+
+	template <class Ty> [[nodiscard]] bool contains() const {
+		return m_archetype->contains<Ty>();
+	}
+
+	template <class Ty> [[nodiscard]] Ty& component() {
+		return m_archetype->component<Ty>(0);
+	}
+	template <class Ty> [[nodiscard]] const Ty& component() const {
+		return m_archetype->component<Ty>(0);
+	}
+
+	[[nodiscard]] Prefab& at(string_view_t name) {
+		for (auto& child : m_children) if (child->m_name == name) return *child;
+		throw std::out_of_range("etcs::Prefab::at(): Prefab has no child with the requested name!");
+	}
+	[[nodiscard]] const Prefab& at(string_view_t name) const {
+		for (const auto& child : m_children) if (child->m_name == name) return *child;
+		throw std::out_of_range("etcs::Prefab::at(): Prefab has no child with the requested name!");
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return m_children.size();
+	}
+	[[nodiscard]] string_view_t name() const noexcept {
+		return m_name;
+	}
+
+private:
+	string_t m_name;
+	unique_ptr_t<detail::Archetype> m_archetype;
+
+	vector_t<prefab_handle> m_children;
 
+	friend class detail::EntityManager;
 };
 
 } // namespace etcs
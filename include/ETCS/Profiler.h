@@ -0,0 +1,60 @@
+/*************************
+ * @file Profiler.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Profiling hooks and chrome trace export
+ *
+ * @date 2024-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Detail/Core.h"
+
+#include <ostream>
+
+namespace etcs {
+
+// writes all recorded events in the chrome trace event format, should be called while no thread is recording
+// without ETCS_ENABLE_PROFILING, nothing is ever recorded and the trace is empty
+void writeChromeTrace(std::ostream& stream);
+void clearProfile();
+
+#ifdef ETCS_ENABLE_PROFILING
+
+namespace detail {
+
+[[nodiscard]] std::uint64_t profileTimestamp() noexcept; // nanoseconds since the start of the program
+void recordProfileEvent(const char* name, std::uint64_t begin, std::uint64_t end) noexcept; // name has to be a string literal
+
+class ProfileScope {
+public:
+	ProfileScope(const char* name) noexcept : m_name(name), m_begin(profileTimestamp()) { }
+	ProfileScope(const ProfileScope&) = delete;
+	~ProfileScope() {
+		recordProfileEvent(m_name, m_begin, profileTimestamp());
+	}
+
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* m_name;
+	std::uint64_t m_begin;
+};
+
+} // namespace detail
+
+#define ETCS_PROFILE_CONCAT_IMPL(first, second) first##second
+#define ETCS_PROFILE_CONCAT(first, second) ETCS_PROFILE_CONCAT_IMPL(first, second)
+
+#define ETCS_PROFILE_SCOPE(name) ::etcs::detail::ProfileScope ETCS_PROFILE_CONCAT(etcsProfileScope, __LINE__)(name)
+
+#else
+
+#define ETCS_PROFILE_SCOPE(name) ((void)0)
+
+#endif
+
+} // namespace etcs
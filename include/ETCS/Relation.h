@@ -0,0 +1,22 @@
+/*************************
+ * @file Relation.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Relations between entities, which are part of the archetype signature
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+namespace etcs {
+
+// a relation is any type used as a tag for the link from an entity to a single target entity
+// entities are grouped into one archetype per target, so e.g. all children of the same parent are stored next to each other
+// when the target is erased, the relation is erased from all entities which still have it and the archetypes of the target are destroyed at the next World::nextFrame()
+
+struct ChildOf { }; // kept in sync with the hierarchy of the world, so it can't be inserted or erased directly
+
+} // namespace etcs
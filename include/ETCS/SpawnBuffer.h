@@ -0,0 +1,61 @@
+/*************************
+ * @file SpawnBuffer.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Entities spawned from worker threads and inserted into their world at a sync point
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Detail/Core.h"
+#include "Detail/EntityManager.h"
+
+#include "Entity.h"
+#include "World.h"
+#include "Prefab.h"
+
+namespace etcs {
+
+// owned by a single worker thread, which reserves the ids of its entities in blocks from the world without any lock
+// the entities only exist in the world once the buffer was published on the thread owning the world
+// like publishing, destroying the buffer happens on the thread owning the world and before the world is erased, since it returns the ids it didn't use
+class SpawnBuffer {
+public:
+	static constexpr std::size_t blockSize = 256; // ids reserved at once
+
+	SpawnBuffer(World world) : m_world(world) { }
+	SpawnBuffer(SpawnBuffer&& other) noexcept;
+	SpawnBuffer(const SpawnBuffer&) = delete;
+	~SpawnBuffer(); // entities which weren't published are discarded
+
+	SpawnBuffer& operator=(SpawnBuffer&& other);
+	SpawnBuffer& operator=(const SpawnBuffer&) = delete;
+
+	Entity spawn(string_view_t name = { }); // the handle can be kept, but is only valid after publishing
+	Entity spawn(const Prefab& prefab); // the prefab has to outlive the buffer until it is published
+
+	void publish(); // at the sync point, also returns the unused ids of the current block to the world
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return m_entities.size();
+	}
+	[[nodiscard]] bool empty() const noexcept {
+		return m_entities.empty();
+	}
+
+private:
+	World m_world;
+	vector_t<detail::ReservedEntity> m_entities;
+
+	object_id m_next = nullId; // remaining ids of the reserved block
+	object_id m_end = nullId;
+
+	object_id reserveId();
+	void release(); // ids of the unpublished entities and the rest of the current block
+};
+
+} // namespace etcs
@@ -0,0 +1,72 @@
+/*************************
+ * @file StagedWorld.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Worlds built on worker threads and handed to the live worlds at a sync point
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Detail/Core.h"
+#include "Detail/WorldData.h"
+
+#include "World.h"
+
+#include <mutex>
+
+namespace etcs {
+
+// world which isn't registered with the world manager, so it is constructed and populated without synchronizing with any other world
+// only one thread may access it at a time until it is handed off
+class StagedWorld {
+public:
+	StagedWorld(string_view_t name = { }, memory_resource* upstream = std::pmr::get_default_resource());
+	StagedWorld(World target, string_view_t name = { }); // columns are allocated from the memory of target, so merging into it relinks whole columns instead of moving their components
+	StagedWorld(StagedWorld&&) = default;
+
+	StagedWorld& operator=(StagedWorld&&) = default;
+
+	[[nodiscard]] World world() noexcept { // for populating the world, invalid once it was handed off
+		return World(m_data.get());
+	}
+	[[nodiscard]] string_view_t name() const noexcept {
+		return World(m_data.get()).name();
+	}
+
+private:
+	unique_ptr_t<detail::WorldData> m_data;
+
+	friend class WorldHandoff;
+	friend World publishWorld(StagedWorld&& world);
+};
+
+World publishWorld(StagedWorld&& world); // registers the world with the world manager, so it can be found by its name
+
+
+// staged worlds finished by worker threads, only pushing a world and taking all of them at the sync point are synchronized
+class WorldHandoff {
+public:
+	WorldHandoff() = default;
+	WorldHandoff(const WorldHandoff&) = delete;
+
+	WorldHandoff& operator=(const WorldHandoff&) = delete;
+
+	void push(StagedWorld&& world); // from any thread
+
+	std::size_t mergeInto(World target); // merges all finished worlds into target and frees them, returns how many there were
+	std::size_t publish(); // registers all finished worlds with the world manager, returns how many there were
+
+	[[nodiscard]] bool empty() const;
+
+private:
+	vector_t<StagedWorld> m_pending;
+	mutable std::mutex m_mutex;
+
+	vector_t<StagedWorld> take(); // the lock is only held while swapping out the pending worlds
+};
+
+} // namespace etcs
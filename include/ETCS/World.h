@@ -19,6 +19,8 @@
 #include "EntityQuery.h"
 #include "EntityRange.h"
 #include "Component.h"
+#include "Prefab.h"
+#include "MemoryStats.h"
 
 namespace etcs {
 
@@ -27,6 +29,8 @@ void quit();
 
 World world(string_view_t name = { });
 World insertWorld(string_view_t name);
+World insertWorld(string_view_t name, memory_resource* upstream); // all memory of the world is allocated from upstream and freed at once when it is erased
+World forkWorld(World source, string_view_t name); // erasing the source waits until it was copied, throws if it already was; takes read access of the source, so not while the calling thread holds access to it
 
 void eraseWorld(string_view_t name);
 void eraseWorld(World world);
@@ -46,13 +50,31 @@ public:
 	Entity insertEntity(string_view_t name, const Entity& parent) {
 		return m_data->m_entities.insert(name, parent.m_id);
 	}
-	void eraseEntity(const Entity& entity) {
+	void eraseEntity(const Entity& entity) { // the children are handed to the parent of the entity, each one renamed to name#id if the parent already has a child with its name
 		m_data->m_entities.erase(entity.m_id);
 	}
+	void eraseEntities(span_t<const Entity> entities) { // with all of their descendants, every archetype compacts its columns only once
+		m_data->m_entities.eraseSubtrees(entities);
+	}
+	void reparent(span_t<const Entity> entities, const Entity& parent) { // entities are renamed to name#id if parent already has a child with their name
+		m_data->m_entities.reparent(entities, parent.m_id);
+	}
 	void clearEntity(const Entity& entity) {
 		m_data->m_entities.clear(entity.m_id);
 	}
 
+	void merge(const World& other) { // moves all entities of other into this world, other stays alive but empty
+		// a column is relinked as a whole if other allocated it from the memory of this world (see StagedWorld) and the column here is still empty, otherwise its components are moved one by one into the memory of this world
+		m_data->m_entities.insertFrom(other.m_data->m_entities);
+	}
+	vector_t<Entity> transfer(span_t<const Entity> entities, const World& target) { // with all of their descendants, returns the entities in target in the same order
+		return target.m_data->m_entities.insertFrom(m_data->m_entities, entities);
+	}
+
+	vector_t<Entity> instantiate(const Prefab& prefab, std::size_t count = 1) {
+		return m_data->m_entities.insert(prefab, count);
+	}
+
 	bool containsEntity(const Entity& entity) {
 		return m_data->m_entities.contains(entity.m_id);
 	}
@@ -66,45 +88,109 @@ public:
 	template <class Ty> void eraseComponent(const Entity& entity) {
 		m_data->eraseComponent<Ty>(entity.m_id, entity.m_index);
 	}
+	template <class Ty, class... Args> void setSharedComponent(const Entity& entity, Args&&... args) {
+		m_data->setSharedComponent<Ty>(entity.m_id, entity.m_index, std::forward<Args>(args)...);
+	}
+
+	template <class Ty, class... Types> void insertComponentAll(EntityQuery<Types...>& query, const Ty& component = Ty { }) { // entities which already have the component are skipped, the query has to be constructed again to find the moved entities
+		query.m_entityQuery.template insertComponentAll<Ty>(component);
+	}
+	template <class Ty, class... Types> void eraseComponentAll(EntityQuery<Types...>& query) { // entities without the component are skipped
+		query.m_entityQuery.template eraseComponentAll<Ty>();
+	}
 
 	template <class Ty> bool containsComponent(const Entity& entity) const {
 		return m_data->containsComponent<Ty>(entity.m_id, entity.m_index);
 	}
 
 
+	// relation functions
+
+	template <class Relation> void insertRelation(const Entity& entity, const Entity& target) {
+		entity.insertRelation<Relation>(target);
+	}
+	template <class Relation> void eraseRelation(Entity entity) {
+		entity.eraseRelation<Relation>();
+	}
+
+
 	// iteration
 
 	EntityRange entities() {
 		return EntityRange(m_data);
 	}
-	template <class... Types> EntityQuery<Types...> query() {
-		return EntityQuery<Types...>(m_data);
+	template <class... Types> EntityQuery<Types...> query(QueryOrder order = QueryOrder::archetype) {
+		return EntityQuery<Types...>(m_data, order);
+	}
+	template <class Relation, class... Types> EntityQuery<Types...> queryRelated(const Entity& target) { // only the archetypes of entities whose relation points to target
+		return EntityQuery<Types...>(m_data, QueryOrder::archetype, detail::RelationFilter { lsd::typeId<Relation>(), { }, target.m_id });
 	}
 
 	
 	// world functions
 
-	bool alive() {
-		return containsWorld(m_data->m_name);
+	void nextFrame() { // destroys the archetypes emptied for good by erased relation targets and invalidates all scratch memory used for temporaries of the previous frame
+		m_data->nextFrame();
+	}
+
+	bool alive() const { // only compares the generation of the slot of the world, without looking up its name
+		return containsWorld(*this);
 	}
 	void destroy() {
-		eraseWorld(m_data->m_name);
+		eraseWorld(*this);
+	}
+	World fork(string_view_t name) const {
+		return forkWorld(*this, name);
 	}
 
 	[[nodiscard]] string_view_t name() const {
 		return m_data->m_name;
 	}
+	[[nodiscard]] WorldMemoryStats memoryStats() const {
+		WorldMemoryStats stats;
+		stats.entities = m_data->m_entities.memoryStats();
+		m_data->m_archetypes.memoryStats(stats);
+		m_data->m_entities.sparse().memoryStats(stats);
+		m_data->m_archetypes.shared().memoryStats(stats);
+
+		return stats;
+	}
+
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+	[[nodiscard]] WorldAllocationStats allocationStats() const noexcept { // indexed by AllocationTag
+		return m_data->m_memory->allocationStats();
+	}
+#endif
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+	[[nodiscard]] WorldPerfCounters perfCounters() const noexcept { // indexed by PerfOperation
+		return m_data->m_perfCounters.snapshot();
+	}
+	void resetPerfCounters() noexcept {
+		m_data->m_perfCounters.reset();
+	}
+#endif
 
 private:
-	detail::WorldData* m_data;
+	detail::WorldData* m_data = { };
+
+	std::size_t m_slot = std::numeric_limits<std::size_t>::max(); // in the world manager, identifies the world together with the generation
+	std::uint32_t m_generation = 0;
 
-	World(detail::WorldData* data) : m_data(data) { }
+	World(detail::WorldData* data) : m_data(data), m_slot(data->m_slot), m_generation(data->m_generation) { }
 
 	friend class detail::WorldManager;
 	friend class detail::BasicEntityQuery;
+	friend class StagedWorld;
+	friend class SpawnBuffer;
+	friend class ReadAccess;
+	friend class WriteAccess;
 	friend class detail::BasicQueryIterator;
 	friend class EntityRange;
 	friend class Entity;
+
+	friend World forkWorld(World, string_view_t);
+	friend void eraseWorld(World);
+	friend bool containsWorld(World);
 };
 
 } // namespace etcs
@@ -0,0 +1,72 @@
+/*************************
+ * @file WorldAccess.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Shared read access and exclusive write access to a world from multiple threads
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include "Detail/Core.h"
+#include "Detail/AccessGuard.h"
+
+#include "World.h"
+#include "EntityQuery.h"
+
+namespace etcs {
+
+// any number of threads can hold read access to a world at once, during which only queries of const components are constructed through it
+// not reentrant, a thread can't acquire read or write access to a world it already holds access to
+class ReadAccess {
+public:
+	ReadAccess(World world);
+	ReadAccess(const ReadAccess&) = delete;
+	~ReadAccess();
+
+	ReadAccess& operator=(const ReadAccess&) = delete;
+
+	template <class... Types> EntityQuery<Types...> query(QueryOrder order = QueryOrder::archetype) {
+		static_assert(!detail::QueryTerms<Types...>::writable, "etcs::ReadAccess::query(): Only const components can be queried under read access!");
+
+		m_world.m_data->m_access.insertReads(m_reader, detail::QueryTerms<Types...>::accesses);
+		return m_world.query<Types...>(order);
+	}
+	template <class Relation, class... Types> EntityQuery<Types...> queryRelated(const Entity& target) {
+		static_assert(!detail::QueryTerms<Types...>::writable, "etcs::ReadAccess::queryRelated(): Only const components can be queried under read access!");
+
+		m_world.m_data->m_access.insertReads(m_reader, detail::QueryTerms<Types...>::accesses);
+		return m_world.queryRelated<Relation, Types...>(target);
+	}
+
+	[[nodiscard]] World world() const noexcept { // for looking up entities and other functions which don't change the world
+		return m_world;
+	}
+
+private:
+	World m_world;
+	detail::AccessReader m_reader;
+};
+
+// excludes all other accesses to a world, waits until all read accesses are released
+// structural changes without write access are only checked against active read accesses with ETCS_ENABLE_ACCESS_CHECKS
+class WriteAccess {
+public:
+	WriteAccess(World world);
+	WriteAccess(const WriteAccess&) = delete;
+	~WriteAccess();
+
+	WriteAccess& operator=(const WriteAccess&) = delete;
+
+	[[nodiscard]] World world() const noexcept {
+		return m_world;
+	}
+
+private:
+	World m_world;
+};
+
+} // namespace etcs
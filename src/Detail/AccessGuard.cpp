@@ -0,0 +1,133 @@
+#include "../../include/ETCS/Detail/AccessGuard.h"
+
+#include <stdexcept>
+
+namespace etcs {
+
+namespace detail {
+
+void AccessGuard::lockRead(AccessReader& reader, const char* operation) {
+	m_mutex.lock_shared();
+
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+	reader.thread = std::this_thread::get_id();
+
+	{
+		std::lock_guard lock(m_readerMutex);
+
+		m_readers.push_back(&reader);
+		m_readerCount.fetch_add(1, std::memory_order_seq_cst);
+	}
+
+	// the reader is published before the writers are checked and beginWrite does the opposite, so with sequential consistency at least one of them sees the other
+	if (m_writers.load(std::memory_order_seq_cst) != 0) { // a structural change which doesn't hold write access is still in progress
+		auto change = m_writeOperation.load(std::memory_order_relaxed);
+		unlockRead(reader);
+
+		throw std::logic_error(std::string(operation) + "(): Read access conflicts with the concurrent structural change " + (change ? change : "") + "!");
+	}
+#else
+	(void)reader;
+	(void)operation;
+#endif
+}
+
+void AccessGuard::unlockRead(AccessReader& reader) noexcept {
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+	{
+		std::lock_guard lock(m_readerMutex);
+
+		m_readers.erase(std::find(m_readers.begin(), m_readers.end(), &reader));
+		m_readerCount.fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	reader.components.clear();
+#else
+	(void)reader;
+#endif
+
+	m_mutex.unlock_shared();
+}
+
+void AccessGuard::lockWrite() {
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+	if (m_readerCount.load(std::memory_order_acquire) != 0) { // waiting for the own read access would never return
+		std::lock_guard lock(m_readerMutex);
+
+		if (std::any_of(m_readers.begin(), m_readers.end(), [](auto reader) { return reader->thread == std::this_thread::get_id(); }))
+			throw std::logic_error("etcs::WriteAccess::WriteAccess(): The calling thread still holds read access of " + readNames() + "!");
+	}
+#endif
+
+	m_mutex.lock();
+}
+
+void AccessGuard::unlockWrite() noexcept {
+	m_mutex.unlock();
+}
+
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+
+void AccessGuard::beginWrite(const char* operation, const ComponentAccess* component) {
+	m_writeOperation.store(operation, std::memory_order_relaxed);
+	m_writers.fetch_add(1, std::memory_order_seq_cst); // published before the readers are checked, see lockRead()
+
+	if (m_readerCount.load(std::memory_order_seq_cst) != 0) {
+		std::lock_guard lock(m_readerMutex);
+
+		if (!m_readers.empty()) {
+			std::logic_error error(
+				std::string(operation) + "(): " + (component ? "Writing " + std::string(component->name) : std::string("Structural change")) +
+				" conflicts with " + std::to_string(m_readers.size()) + (m_readers.size() == 1 ? " concurrent read access of " : " concurrent read accesses of ") + readNames() + "!"
+			);
+
+			endWrite();
+			throw error;
+		}
+	}
+}
+
+void AccessGuard::checkQuery(span_t<const ComponentAccess> components) const {
+	if (m_readerCount.load(std::memory_order_acquire) == 0) return;
+
+	std::lock_guard lock(m_readerMutex);
+
+	std::string conflicts; // only the written components which are also read, all others can be written in parallel
+	for (const auto& component : components) {
+		if (!component.writable || !read(component.typeId)) continue;
+
+		if (!conflicts.empty()) conflicts += ", ";
+		conflicts += component.name;
+	}
+
+	if (!conflicts.empty()) throw std::logic_error("etcs::World::query(): Writing " + conflicts + " conflicts with concurrent read accesses of the same components!");
+}
+
+bool AccessGuard::read(lsd::type_id typeId) const noexcept {
+	return std::any_of(m_readers.begin(), m_readers.end(), [typeId](auto reader) {
+		return std::any_of(reader->components.begin(), reader->components.end(), [typeId](const auto& component) { return component.typeId == typeId; });
+	});
+}
+
+std::string AccessGuard::readNames() const {
+	std::string names;
+	vector_t<lsd::type_id> listed;
+
+	for (auto reader : m_readers) {
+		for (const auto& component : reader->components) {
+			if (std::find(listed.begin(), listed.end(), component.typeId) != listed.end()) continue;
+			listed.push_back(component.typeId);
+
+			if (!names.empty()) names += ", ";
+			names += component.name;
+		}
+	}
+
+	return names.empty() ? std::string("no components") : names;
+}
+
+#endif
+
+} // namespace detail
+
+} // namespace etcs
@@ -2,42 +2,241 @@
 
 #include "../../include/ETCS/World.h"
 
+#include <algorithm>
+
 namespace etcs {
 
 namespace detail {
 
-std::size_t Archetype::superHash(lsd::type_id typeId) {
-	auto hash = m_components.size() + 1;
+namespace {
 
-	auto inserted = false;
+std::size_t mix(std::uint64_t z) noexcept {
+	z += 0x9e3779b97f4a7c15;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
 
-	for (const auto& [id, _] : m_components) {
-		if (id > typeId) {
-			inserted = true;
-			hash ^= reinterpret_cast<std::uintptr_t>(typeId) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-		}
+	return static_cast<std::size_t>(z ^ (z >> 31));
+}
 
-		hash ^= reinterpret_cast<std::uintptr_t>(id) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-	}
-	if (!inserted) hash ^= reinterpret_cast<std::uintptr_t>(typeId) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+// type ids are addresses lying close together, so they are mixed before being combined, otherwise distinct archetypes collide
+std::size_t mixTypeId(lsd::type_id typeId) noexcept {
+	return mix(reinterpret_cast<std::uintptr_t>(typeId));
+}
+std::size_t mixValue(lsd::type_id typeId, std::size_t value) noexcept { // shared values and relation targets, not linear in the value, so equal values of different types don't cancel out
+	return mix(reinterpret_cast<std::uintptr_t>(typeId) ^ mix(value + 1));
+}
 
-	return hash;
+} // namespace
+
+// the hash of an archetype is the xor of all of its mixed component and tag ids, so it doesn't depend on how they are ordered or stored
+std::size_t Archetype::superHash(lsd::type_id typeId) {
+	return m_hash ^ mixTypeId(typeId);
 }
 
 std::size_t Archetype::subHash(lsd::type_id typeId) {
-	auto hash = m_components.size() - 1;
+	return m_hash ^ mixTypeId(typeId);
+}
+
+std::size_t Archetype::sharedHash(lsd::type_id typeId, std::size_t handle) const {
+	auto hash = m_hash ^ mixValue(typeId, handle);
+	if (auto it = m_shared.find(typeId); it != m_shared.end()) hash ^= mixValue(typeId, it->second.handle);
+
+	return hash;
+}
+
+std::size_t Archetype::subSharedHash(lsd::type_id typeId) const {
+	return m_hash ^ mixValue(typeId, m_shared.at(typeId).handle);
+}
 
-	for (const auto& [id, _] : m_components)
-		if (id != typeId)
-			hash ^= reinterpret_cast<std::uintptr_t>(id) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+std::size_t Archetype::relationHash(lsd::type_id relation, object_id target) const {
+	auto hash = m_hash ^ mixValue(relation, target);
+	if (auto it = m_relations.find(relation); it != m_relations.end()) hash ^= mixValue(relation, it->second);
 
 	return hash;
 }
 
+std::size_t Archetype::subRelationHash(lsd::type_id relation) const {
+	return m_hash ^ mixValue(relation, m_relations.at(relation));
+}
+
+bool Archetype::matches(const Archetype& base, const SignatureEdit& edit) const {
+	auto except = [&edit](SignaturePart part) { return (edit.part == part) ? edit.typeId : lsd::type_id { }; };
+	auto equal = [](const auto& first, const auto& second, lsd::type_id except, auto value) { // entries of except are skipped in both
+		if (first.size() - first.contains(except) != second.size() - second.contains(except)) return false;
+
+		return std::all_of(first.begin(), first.end(), [&](const auto& entry) {
+			if (entry.first == except) return true;
+
+			auto it = second.find(entry.first);
+			return it != second.end() && value(it->second) == value(entry.second);
+		});
+	};
+
+	if (
+		!equal(m_components, base.m_components, except(SignaturePart::component), [](const auto&) { return 0; }) || // columns only differ in their types
+		!equal(m_shared, base.m_shared, except(SignaturePart::shared), [](const SharedValue& value) { return value.handle; }) || 
+		!equal(m_relations, base.m_relations, except(SignaturePart::relation), [](object_id target) { return target; })
+	) return false;
+
+	auto tag = except(SignaturePart::tag);
+	if (
+		m_tags.size() - m_tags.contains(tag) != base.m_tags.size() - base.m_tags.contains(tag) || 
+		!std::all_of(m_tags.begin(), m_tags.end(), [&base, tag](auto id) { return id == tag || base.m_tags.contains(id); })
+	) return false;
+
+	switch (edit.part) { // the changed entry itself
+		case SignaturePart::component:
+			return m_components.contains(edit.typeId) != edit.erase;
+		case SignaturePart::tag:
+			return m_tags.contains(edit.typeId) != edit.erase;
+		case SignaturePart::shared:
+			if (auto it = m_shared.find(edit.typeId); it != m_shared.end()) return !edit.erase && it->second.handle == edit.value;
+			else return edit.erase;
+		case SignaturePart::relation:
+			if (auto it = m_relations.find(edit.typeId); it != m_relations.end()) return !edit.erase && it->second == edit.value;
+			else return edit.erase;
+		default:
+			return true;
+	}
+}
+
+Archetype Archetype::copySignature(std::size_t hash) const {
+	Archetype a(m_resource);
+	a.m_hash = hash;
+	a.m_tags = m_tags;
+	a.m_shared = m_shared;
+	a.m_relations = m_relations;
+
+	for (const auto& component : m_components) a.m_components.emplace(component.first, component.second);
+
+	return a;
+}
+
+Archetype Archetype::createShared(lsd::type_id typeId, SharedValue value, std::size_t hash) const {
+	auto a = copySignature(hash);
+	a.m_shared[typeId] = value;
+
+	return a;
+}
+
+Archetype Archetype::createSubShared(lsd::type_id typeId, std::size_t hash) const {
+	auto a = copySignature(hash);
+	a.m_shared.erase(typeId);
+
+	return a;
+}
+
+Archetype Archetype::createRelation(lsd::type_id relation, object_id target, std::size_t hash) const {
+	auto a = copySignature(hash);
+	a.m_relations[relation] = target;
+
+	return a;
+}
+
+Archetype Archetype::createSubRelation(lsd::type_id relation, std::size_t hash) const {
+	auto a = copySignature(hash);
+	a.m_relations.erase(relation);
+
+	return a;
+}
+
+Archetype Archetype::copyType(memory_resource* resource) const {
+	Archetype a(resource);
+	a.m_hash = m_hash;
+	a.m_tags = m_tags;
+	a.m_shared = m_shared;
+	a.m_relations = m_relations;
+
+	for (const auto& component : m_components) a.m_components.emplace(component.first, ComponentAllocator(component.second, resource));
+
+	return a;
+}
+
+Archetype Archetype::fork(memory_resource* resource) const {
+	Archetype a(resource);
+	a.m_hash = m_hash;
+	a.m_tags = m_tags;
+	a.m_shared = m_shared; // the values are shared with the pools of the forked world
+	a.m_relations = m_relations; // entity ids are the same in both worlds
+	a.m_entities = m_entities;
+
+	for (const auto& component : m_components) a.m_components.emplace(component.first, ComponentAllocator::share(component.second, resource));
+
+	return a;
+}
+
+void Archetype::insertEntityFrom(object_id entityId, Archetype& other) {
+	m_entities.emplace(entityId);
+
+	auto entityIndex = (other.m_entities.find(entityId) - other.m_entities.begin());
+
+	for (auto& component : other.m_components)
+		m_components.at(component.first).emplaceBackData(component.second.componentData(entityIndex));
+
+	other.eraseEntity(entityId);
+}
+
+void Archetype::insertEntitiesFrom(Archetype& other) {
+	if (m_entities.empty()) std::swap(m_entities, other.m_entities);
+	else {
+		for (auto id : other.m_entities) m_entities.emplace(id);
+		other.m_entities.clear();
+	}
+
+	for (auto& component : other.m_components) {
+		if (auto it = m_components.find(component.first); it != m_components.end()) it->second.moveBack(component.second);
+		else component.second.clear(); // the component was erased from all entities
+	}
+}
+
+void Archetype::insertEntitiesFrom(Archetype& other, span_t<const object_id> entityIds, span_t<const object_id> sourceIds, memory_resource* scratch) {
+	pmr_vector_t<std::size_t> rows(scratch);
+	rows.reserve(sourceIds.size());
+
+	for (auto id : sourceIds) {
+		if (auto it = other.m_entities.find(id); it != other.m_entities.end()) rows.push_back(it - other.m_entities.begin());
+		else throw std::out_of_range("etcs::detail::Archetype::insertEntitiesFrom(): Tried to move entity with nonexistant ID!");
+	}
+
+	if (sourceIds.size() == other.m_entities.size()) { // the columns are spliced as a whole, so the ids are inserted in the order of the rows
+		pmr_vector_t<object_id> ordered(scratch);
+		ordered.resize(rows.size());
+		for (std::size_t i = 0; i < rows.size(); i++) ordered[rows[i]] = entityIds[i];
+
+		for (auto id : ordered) m_entities.emplace(id);
+		other.m_entities.clear();
+
+		for (auto& component : other.m_components) m_components.at(component.first).moveBack(component.second);
+	} else {
+		for (std::size_t i = 0; i < rows.size(); i++) {
+			m_entities.emplace(entityIds[i]);
+
+			for (auto& component : other.m_components)
+				m_components.at(component.first).emplaceBackData(component.second.componentData(rows[i]));
+		}
+
+		other.eraseEntities(sourceIds, scratch);
+	}
+}
+
 void Archetype::insertEntity(object_id entityId) {
 	m_entities.emplace(entityId);
 }
 
+void Archetype::insertEntitiesFromPrefab(const pmr_vector_t<object_id>& entityIds, const Archetype& prefab) {
+	for (auto id : entityIds) m_entities.emplace(id);
+
+	for (auto& component : m_components) // the prefab only ever holds a single row
+		component.second.copyBackData(prefab.m_components.at(component.first).componentData(0), entityIds.size());
+}
+
+void Archetype::insertEntityFromPrefab(object_id entityId, const Archetype& prefab) {
+	m_entities.emplace(entityId);
+
+	for (auto& component : m_components)
+		component.second.copyBackData(prefab.m_components.at(component.first).componentData(0), 1);
+}
+
 void Archetype::eraseEntity(object_id entityId) {
 	auto it = m_entities.find(entityId);
 
@@ -49,20 +248,295 @@ void Archetype::eraseEntity(object_id entityId) {
 	} else throw std::out_of_range("etscs::EnitityComponentSystem::Archetype::eraseEntity(): Tried to erase entity with nonexistant ID!");
 }
 
-vector_t<lsd::type_id> Archetype::typeIds() const {
-	vector_t<lsd::type_id> res { };
-	res.reserve(m_components.size());
+void Archetype::eraseEntities(span_t<const object_id> entityIds, memory_resource* scratch) {
+	if (entityIds.size() == m_entities.size()) { // e.g. all children of a destroyed parent
+		m_entities.clear();
+		for (auto& component : m_components) component.second.clear();
+
+		return;
+	}
+
+	pmr_vector_t<std::size_t> indices(scratch);
+	indices.reserve(entityIds.size());
+
+	for (auto id : entityIds) {
+		if (auto it = m_entities.find(id); it != m_entities.end()) indices.push_back(it - m_entities.begin());
+		else throw std::out_of_range("etcs::detail::Archetype::eraseEntities(): Tried to erase entity with nonexistant ID!");
+	}
+
+	std::sort(indices.begin(), indices.end(), std::greater<std::size_t>()); // every gap is filled with an entity which stays
+
+	for (auto index : indices) m_entities.erase(m_entities.begin() + index);
+	for (auto& component : m_components) component.second.eraseComponents(indices);
+}
+
+pmr_vector_t<lsd::type_id> Archetype::typeIds(memory_resource* resource) const {
+	pmr_vector_t<lsd::type_id> res(resource);
+	res.reserve(m_components.size() + m_tags.size() + m_shared.size() + m_relations.size());
 
 	for (const auto& [id, _] : m_components) res.push_back(id);
+	for (auto id : m_tags) res.push_back(id);
+	for (const auto& [id, _] : m_shared) res.push_back(id);
+	for (const auto& [id, _] : m_relations) res.push_back(id);
+
+	return res;
+}
+
+ArchetypeMemoryStats Archetype::memoryStats() const {
+	ArchetypeMemoryStats stats;
+	stats.hash = m_hash;
+	stats.entities = m_entities.size();
+	stats.tags = m_tags.size();
+	stats.sharedComponents = m_shared.size();
+	stats.relations = m_relations.size();
+
+	stats.usedBytes = m_entities.size() * sizeof(object_id);
+	stats.reservedBytes = detail::reservedBytes(m_entities) + detail::reservedBytes(m_components) + detail::reservedBytes(m_tags) + detail::reservedBytes(m_shared) + detail::reservedBytes(m_relations);
+	stats.bucketBytes = detail::bucketBytes(m_entities) + detail::bucketBytes(m_components) + detail::bucketBytes(m_tags) + detail::bucketBytes(m_shared) + detail::bucketBytes(m_relations);
+
+	stats.columns.reserve(m_components.size());
+	for (const auto& [id, column] : m_components) {
+		auto& columnStats = stats.columns.emplace_back(ColumnMemoryStats { 
+			id, 
+			column.elementSize(), 
+			column.emptyComponent() ? 0 : column.count(), 
+			column.capacity(), 
+			column.shared() 
+		});
+
+		stats.usedBytes += columnStats.usedBytes();
+		stats.reservedBytes += columnStats.reservedBytes();
+	}
+
+	return stats;
+}
+
+ArchetypeManager::ArchetypeManager(const ArchetypeManager& source, WorldMemory* memory) : 
+	m_archetypes(allocator_t<archetype_handle>(memory->resource(AllocationTag::columns))), 
+	m_archetypeLookup(allocator_t<std::pair<lsd::type_id, pmr_vector_t<Archetype*>>>(memory->resource(AllocationTag::columns))), 
+	m_targetLookup(allocator_t<std::pair<object_id, pmr_vector_t<Archetype*>>>(memory->resource(AllocationTag::columns))), 
+	m_collisions(allocator_t<std::pair<std::size_t, pmr_vector_t<archetype_handle>>>(memory->resource(AllocationTag::columns))), 
+	m_released(memory->resource(AllocationTag::columns)), 
+	m_shared(source.m_shared, memory), 
+	m_memory(memory) {
+	auto fork = [this, &source, memory](const Archetype& sourceArchetype) {
+		if (sourceArchetype.empty() && std::find(source.m_released.begin(), source.m_released.end(), &sourceArchetype) != source.m_released.end()) return; // no query of the fork can refer to it yet
+
+		insertArchetype(archetype_handle::create(sourceArchetype.fork(memory->resource(AllocationTag::columns))));
+	};
+
+	for (const auto& sourceArchetype : source.m_archetypes) fork(*sourceArchetype); // base archetype is always the first one
+	for (const auto& [_, collisions] : source.m_collisions) for (const auto& sourceArchetype : collisions) fork(*sourceArchetype);
+}
+
+Archetype* ArchetypeManager::addOrFindShared(Archetype* baseArchetype, lsd::type_id typeId, SharedValue value) {
+	auto hash = baseArchetype->sharedHash(typeId, value.handle);
+	return addOrFind(hash, *baseArchetype, SignatureEdit { SignaturePart::shared, typeId, false, value.handle }, [&] { return baseArchetype->createShared(typeId, value, hash); });
+}
+
+Archetype* ArchetypeManager::addOrFindSubsetShared(Archetype* baseArchetype, lsd::type_id typeId) {
+	auto hash = baseArchetype->subSharedHash(typeId);
+	return addOrFind(hash, *baseArchetype, SignatureEdit { SignaturePart::shared, typeId, true }, [&] { return baseArchetype->createSubShared(typeId, hash); });
+}
+
+Archetype* ArchetypeManager::addOrFindRelation(Archetype* baseArchetype, lsd::type_id relation, object_id target) {
+	auto hash = baseArchetype->relationHash(relation, target);
+	return addOrFind(hash, *baseArchetype, SignatureEdit { SignaturePart::relation, relation, false, target }, [&] { return baseArchetype->createRelation(relation, target, hash); });
+}
+
+Archetype* ArchetypeManager::addOrFindSubsetRelation(Archetype* baseArchetype, lsd::type_id relation) {
+	auto hash = baseArchetype->subRelationHash(relation);
+	return addOrFind(hash, *baseArchetype, SignatureEdit { SignaturePart::relation, relation, true }, [&] { return baseArchetype->createSubRelation(relation, hash); });
+}
+
+Archetype* ArchetypeManager::addOrFindSubsetTarget(Archetype* baseArchetype, object_id target) {
+	auto res = baseArchetype;
+	for (const auto& [relation, relationTarget] : baseArchetype->m_relations) if (relationTarget == target) res = addOrFindSubsetRelation(res, relation);
+
+	return res;
+}
+
+Archetype* ArchetypeManager::addOrFindRelations(const Archetype& archetype) {
+	auto res = baseArchetype();
+	for (const auto& [relation, target] : archetype.m_relations) res = addOrFindRelation(res, relation, target);
+
+	return res;
+}
+
+Archetype* ArchetypeManager::addOrFindArchetype(const Archetype& prototype) {
+	return addOrFind(prototype.hash(), prototype, SignatureEdit { }, [&] { return prototype.copyType(m_memory->resource(AllocationTag::columns)); });
+}
+
+Archetype* ArchetypeManager::addOrFindTranslated(const Archetype& source, const SharedStorage& sourceShared, const id_table& ids) {
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	auto prototype = source.copyType(scratch); // handles and targets differ between the worlds, so the hash is translated as well
+	prototype.m_shared.clear();
+	prototype.m_relations.clear();
+
+	for (const auto& [typeId, value] : source.m_shared) {
+		auto translated = m_shared.insertFrom(typeId, sourceShared, value.handle);
+		prototype.m_hash ^= mixValue(typeId, value.handle) ^ mixValue(typeId, translated.handle);
+
+		prototype.m_shared.emplace(typeId, translated);
+	}
+	for (const auto& [relation, target] : source.m_relations) {
+		prototype.m_hash ^= mixValue(relation, target);
+
+		if (auto it = ids.find(target); it != ids.end()) {
+			prototype.m_hash ^= mixValue(relation, it->second);
+			prototype.m_relations.emplace(relation, it->second);
+		}
+	}
+
+	return addOrFindArchetype(prototype);
+}
+
+void ArchetypeManager::memoryStats(WorldMemoryStats& stats) const {
+	stats.archetypeTableBytes = 
+		detail::reservedBytes(m_archetypes) + detail::bucketBytes(m_archetypes) + 
+		detail::reservedBytes(m_archetypeLookup) + detail::bucketBytes(m_archetypeLookup);
+	stats.archetypeTableBytes += detail::reservedBytes(m_targetLookup) + detail::bucketBytes(m_targetLookup);
+	stats.archetypeTableBytes += detail::reservedBytes(m_collisions) + detail::bucketBytes(m_collisions);
+	for (const auto& [_, archetypes] : m_archetypeLookup) stats.archetypeTableBytes += detail::reservedBytes(archetypes);
+	for (const auto& [_, archetypes] : m_targetLookup) stats.archetypeTableBytes += detail::reservedBytes(archetypes);
+
+	stats.archetypes.reserve(m_archetypes.size());
+	auto insertStats = [&stats](const Archetype& archetype) {
+		const auto& archetypeStats = stats.archetypes.emplace_back(archetype.memoryStats());
+
+		stats.archetypeTableBytes += sizeof(Archetype);
+		stats.usedBytes += archetypeStats.usedBytes;
+		stats.reservedBytes += archetypeStats.reservedBytes;
+		stats.bucketBytes += archetypeStats.bucketBytes;
+	};
+
+	for (const auto& archetype : m_archetypes) insertStats(*archetype);
+	for (const auto& [_, collisions] : m_collisions) {
+		stats.archetypeTableBytes += detail::reservedBytes(collisions);
+		for (const auto& archetype : collisions) insertStats(*archetype);
+	}
+}
+
+Archetype* ArchetypeManager::insertArchetype(archetype_handle&& archetype) {
+	auto hash = archetype->hash();
+	Archetype* res;
+
+	if (m_archetypes.find(hash) == m_archetypes.end()) res = m_archetypes.emplace(std::move(archetype)).first->get();
+	else {
+		auto collisions = m_collisions.find(hash);
+		if (collisions == m_collisions.end()) collisions = m_collisions.emplace(hash, pmr_vector_t<archetype_handle>(allocator_t<archetype_handle>(m_memory->resource(AllocationTag::columns)))).first;
+
+		res = collisions->second.emplace_back(std::move(archetype)).get();
+	}
+
+	insertLookup(res);
+	for (const auto& [typeId, value] : res->m_shared) m_shared.reference(typeId, value.handle);
 
 	return res;
 }
 
-void ArchetypeManager::querySupersets(vector_t<Archetype*>& archetypes, vector_t<lsd::type_id> types) {
+void ArchetypeManager::eraseArchetype(Archetype* archetype) {
+	eraseLookup(archetype);
+	for (const auto& [typeId, value] : archetype->m_shared) m_shared.release(typeId, value.handle);
+
+	auto hash = archetype->hash();
+	auto collisions = m_collisions.find(hash);
+
+	if (collisions == m_collisions.end()) {
+		m_archetypes.erase(hash);
+		return;
+	}
+
+	auto& list = collisions->second;
+	if (auto it = std::find_if(list.begin(), list.end(), [archetype](const auto& collision) { return collision.get() == archetype; }); it != list.end()) list.erase(it);
+	else { // the first collision takes the place of the archetype in the set, so it can still be found by its hash
+		m_archetypes.erase(hash);
+		m_archetypes.emplace(std::move(list.back()));
+		list.popBack();
+	}
+
+	if (list.empty()) m_collisions.erase(collisions);
+}
+
+void ArchetypeManager::insertLookup(Archetype* archetype) {
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	for (auto types = archetype->typeIds(scratch); auto id : types) {
+		auto it = m_archetypeLookup.find(id);
+		if (it == m_archetypeLookup.end()) it = m_archetypeLookup.emplace(id, pmr_vector_t<Archetype*>(allocator_t<Archetype*>(m_memory->resource(AllocationTag::columns)))).first; // operator[] would default construct the list with the default resource
+
+		it->second.emplace_back(archetype);
+	}
+
+	for (const auto& [_, target] : archetype->m_relations) {
+		auto it = m_targetLookup.find(target);
+		if (it == m_targetLookup.end()) it = m_targetLookup.emplace(target, pmr_vector_t<Archetype*>(allocator_t<Archetype*>(m_memory->resource(AllocationTag::columns)))).first;
+
+		if (std::find(it->second.begin(), it->second.end(), archetype) == it->second.end()) it->second.emplace_back(archetype); // an archetype can have multiple relations to the same target
+	}
+}
+
+void ArchetypeManager::eraseLookup(Archetype* archetype) {
+	auto eraseFrom = [archetype](pmr_vector_t<Archetype*>& archetypes) {
+		if (auto it = std::find(archetypes.begin(), archetypes.end(), archetype); it != archetypes.end()) archetypes.erase(it);
+	};
+
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	for (auto types = archetype->typeIds(scratch); auto id : types) 
+		if (auto it = m_archetypeLookup.find(id); it != m_archetypeLookup.end()) eraseFrom(it->second);
+
+	for (const auto& [_, target] : archetype->m_relations) {
+		if (auto it = m_targetLookup.find(target); it != m_targetLookup.end()) {
+			eraseFrom(it->second);
+			if (it->second.empty()) m_targetLookup.erase(it);
+		}
+	}
+}
+
+void ArchetypeManager::querySupersets(pmr_vector_t<Archetype*>& archetypes, const QueryFilter& filter) {
+	using lookup_set = lsd::UnorderedSparseSet<Archetype*, hash_t<Archetype*>, std::equal_to<Archetype*>, allocator_t<Archetype*>>;
+
+	const auto& types = filter.required;
+
+	if (types.empty()) { // without required components, the candidates are either all archetypes with one alternative of the first any of term or just all archetypes
+		if (filter.anyOfEnds.empty()) {
+			for (const auto& archetype : m_archetypes) 
+				if (!archetype->empty() && filter.matchesExclusions(*archetype)) archetypes.push_back(archetype.get());
+			for (const auto& [_, collisions] : m_collisions) for (const auto& archetype : collisions) 
+				if (!archetype->empty() && filter.matchesExclusions(*archetype)) archetypes.push_back(archetype.get());
+		} else {
+			auto alternatives = filter.anyOf.first(filter.anyOfEnds.front());
+
+			for (auto typeIt = alternatives.begin(); typeIt != alternatives.end(); typeIt++) {
+				auto archetypeArray = m_archetypeLookup.find(*typeIt);
+				if (archetypeArray == m_archetypeLookup.end()) continue;
+
+				for (auto archetype : archetypeArray->second) {
+					if (
+						archetype->empty() || 
+						std::any_of(alternatives.begin(), typeIt, [archetype](auto id) { return archetype->contains(id); }) // already added through a previous alternative
+					) continue;
+
+					if (filter.matchesExclusions(*archetype)) archetypes.push_back(archetype);
+				}
+			}
+		}
+
+		return;
+	}
+
 	auto baseArchetypeArray = m_archetypeLookup.find(types.front());
 	if (baseArchetypeArray == m_archetypeLookup.end()) return;	
 
-	vector_t<lsd::UnorderedSparseSet<Archetype*>> archetypeLookup;
+	auto scratch = m_memory->scratch(); // all temporaries are allocated from the scratch memory of the current thread
+	LinearResource::Scope scope(scratch);
+
+	pmr_vector_t<lookup_set> archetypeLookup(scratch); // passes the scratch allocator on to every set, which allocates its array and buckets with it
 	archetypeLookup.reserve(types.size() - 1);
 
 	for (auto typeIt = ++types.begin(); typeIt != types.end(); typeIt++) {
@@ -73,10 +547,10 @@ void ArchetypeManager::querySupersets(vector_t<Archetype*>& archetypes, vector_t
 		if (archetypeArray->second.size() == 0) return;
 
 		if (archetypeArray->second.size() < baseArchetypeArray->second.size()) {
-			archetypeLookup.emplace_back(baseArchetypeArray->second.begin(), baseArchetypeArray->second.end());
+			archetypeLookup.emplace_back(baseArchetypeArray->second.begin(), baseArchetypeArray->second.end(), 0);
 
 			baseArchetypeArray = archetypeArray;
-		} else archetypeLookup.emplace_back(archetypeArray->second.begin(), archetypeArray->second.end());
+		} else archetypeLookup.emplace_back(archetypeArray->second.begin(), archetypeArray->second.end(), 0);
 	}
 
 	archetypes.reserve(baseArchetypeArray->second.size());
@@ -92,11 +566,83 @@ void ArchetypeManager::querySupersets(vector_t<Archetype*>& archetypes, vector_t
 				}
 			}
 
-			if (found) archetypes.push_back(archetype);
+			if (found && filter.matchesExclusions(*archetype)) archetypes.push_back(archetype);
 		}
 	}
 }
 
+void ArchetypeManager::queryRelated(pmr_vector_t<Archetype*>& archetypes, const QueryFilter& filter, object_id target) {
+	auto targetArray = m_targetLookup.find(target);
+	if (targetArray == m_targetLookup.end()) return;
+
+	for (auto archetype : targetArray->second) { // usually far fewer than the archetypes with the required components, so they are checked directly
+		if (
+			!archetype->empty() && 
+			std::all_of(filter.required.begin(), filter.required.end(), [archetype](auto id) { return archetype->contains(id); }) && 
+			filter.matchesExclusions(*archetype)
+		) archetypes.push_back(archetype);
+	}
+}
+
+Archetype* ArchetypeManager::findRelated(object_id target) {
+	auto targetArray = m_targetLookup.find(target);
+	if (targetArray == m_targetLookup.end()) return nullptr;
+
+	auto it = std::find_if(targetArray->second.begin(), targetArray->second.end(), [](auto archetype) { return !archetype->empty(); });
+	return (it != targetArray->second.end()) ? *it : nullptr;
+}
+
+void ArchetypeManager::releaseRelated(object_id target) {
+	auto targetArray = m_targetLookup.find(target);
+	if (targetArray == m_targetLookup.end()) return;
+
+	for (auto archetype : targetArray->second) {
+		assert(archetype->empty() && "etcs::detail::ArchetypeManager::releaseRelated(): Entities still have a relation to the erased target!");
+		m_released.push_back(archetype);
+	}
+}
+
+void ArchetypeManager::reclaim() {
+	{ // every value of a shared component has its own archetypes, so they are only kept while they have entities
+		auto scratch = m_memory->scratch();
+		LinearResource::Scope scope(scratch);
+
+		for (auto types = m_shared.typeIds(scratch); auto id : types) 
+			if (auto it = m_archetypeLookup.find(id); it != m_archetypeLookup.end()) 
+				for (auto archetype : it->second) if (archetype->empty()) m_released.push_back(archetype);
+	}
+
+	if (!m_released.empty()) {
+		std::sort(m_released.begin(), m_released.end()); // an archetype with several relations can be released once per target
+		m_released.erase(std::unique(m_released.begin(), m_released.end()), m_released.end());
+
+		for (auto archetype : m_released) {
+			if (archetype->empty()) eraseArchetype(archetype); // otherwise the id of the target was reused in the meantime
+		}
+
+		m_released.clear();
+		m_generation++;
+	}
+
+	m_shared.reclaim(); // after the archetypes which referred to the values were erased
+}
+
+
+
+// QueryFilter
+
+bool QueryFilter::matchesExclusions(const Archetype& archetype) const {
+	for (auto id : excluded) if (archetype.contains(id)) return false;
+
+	auto begin = anyOf.begin();
+	for (auto end : anyOfEnds) {
+		if (std::none_of(begin, anyOf.begin() + end, [&archetype](auto id) { return archetype.contains(id); })) return false;
+		begin = anyOf.begin() + end;
+	}
+
+	return true;
+}
+
 } // namespace detail
 
 } // namespace etcs
@@ -2,39 +2,118 @@
 
 #include "../../include/ETCS/Detail/WorldData.h"
 #include "../../include/ETCS/Entity.h"
+#include "../../include/ETCS/Prefab.h"
 
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 
 namespace etcs {
 
 namespace detail {
 
+EntityName::EntityName(string_view_t name, memory_resource* resource) : m_resource(resource) {
+	assign(name);
+}
+
+EntityName::~EntityName() {
+	release();
+}
+
+EntityName& EntityName::operator=(EntityName&& other) noexcept {
+	if (this != &other) {
+		release();
+
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_resource = other.m_resource;
+	}
+
+	return *this;
+}
+
+void EntityName::assign(string_view_t name) {
+	auto data = name.empty() ? nullptr : static_cast<char*>(m_resource->allocate(name.size(), alignof(char)));
+	std::copy(name.begin(), name.end(), data); // name may be a view of the current allocation
+
+	release();
+
+	m_data = data;
+	m_size = name.size();
+}
+
+void EntityName::release() noexcept {
+	if (m_data) m_resource->deallocate(m_data, m_size, alignof(char));
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+
+EntityManager::EntityManager(const EntityManager& source, WorldData* world, WorldMemory* memory) : 
+	m_lookup(allocator_t<std::pair<EntityData, Archetype*>>(memory->resource(AllocationTag::entities))), 
+	m_unused(source.m_unused, allocator_t<object_id>(memory->resource(AllocationTag::entities))), 
+	m_nextId(source.m_nextId.load(std::memory_order_relaxed)), 
+	m_sparse(source.m_sparse, memory), 
+	m_world(world), 
+	m_memory(memory) {
+	for (const auto& [sourceData, archetype] : source.m_lookup) { // archetypes are looked up by hash in the new world
+		auto& data = m_lookup.emplace(EntityData(sourceData.m_id, sourceData.m_name, m_memory), m_world->m_archetypes.addOrFindArchetype(*archetype)).first->first;
+		data.m_parent.id = sourceData.m_parent.id;
+		data.m_depth = sourceData.m_depth;
+	}
+
+	for (auto& [data, _] : m_lookup) { // the views have to point to the names of this world
+		if (auto parent = m_lookup.find(data.m_parent.id); parent != m_lookup.end()) {
+			data.m_parent.name = parent->first.m_name;
+			parent->first.m_children.emplace(EntityView { data.m_id, data.m_name });
+		}
+	}
+}
+
 object_id EntityManager::uniqueId() {
-	if (m_unused.empty()) {
-		if (m_lookup.size() == std::numeric_limits<std::size_t>::max()) throw std::runtime_error("etcs::detail::EntityManager::uniqueId(): Current entity count exceeded max entity count!");
-		else return m_lookup.size();
-	} else {
+	if (m_unused.empty()) return reserveIds(1); // the size of the lookup may already be in use after an entity was erased
+	else {
 		auto id = m_unused.back();
 		m_unused.popBack();
 		return id;
 	}
 }
 
+object_id EntityManager::reserveIds(std::size_t count) {
+	auto id = m_nextId.load(std::memory_order_relaxed);
+
+	do { // checked before the block is taken, so a failed reservation never moves the counter past the last valid id
+		if (count > nullId || id > nullId - count) throw std::runtime_error("etcs::detail::EntityManager::reserveIds(): Current entity count exceeded max entity count!");
+	} while (!m_nextId.compare_exchange_weak(id, id + count, std::memory_order_relaxed));
+
+	return id;
+}
+
+void EntityManager::releaseIds(object_id first, std::size_t count) {
+	m_unused.reserve(m_unused.size() + count);
+	for (auto id = first; id < first + count; id++) m_unused.push_back(id);
+}
+
 Entity EntityManager::insert(string_view_t name) {
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::insertEntity");
+
 	auto archetype = m_world->m_archetypes.baseArchetype();
 
-	auto res = m_lookup.emplace(EntityData(uniqueId(), name), archetype).first;
+	auto res = m_lookup.emplace(EntityData(uniqueId(), name, m_memory), archetype).first;
 	archetype->insertEntity(res->first.m_id);
 
 	return Entity(res->first.m_id, res - m_lookup.begin(), m_world);
 }
 
 Entity EntityManager::insert(string_view_t name, object_id parentId) {
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::insertEntity");
+
 	if (auto parent = m_lookup.find(parentId); parent != m_lookup.end()) {
 		if (auto it = parent->first.m_children.find(name); it == parent->first.m_children.end()) {
-			auto archetype = m_world->m_archetypes.baseArchetype();
+			auto archetype = m_world->m_archetypes.addOrFindRelation(m_world->m_archetypes.baseArchetype(), lsd::typeId<ChildOf>(), parentId);
 
-			auto eIt = m_lookup.emplace(EntityData(uniqueId(), name, &parent->first), archetype).first;
+			auto eIt = m_lookup.emplace(EntityData(uniqueId(), name, &parent->first, m_memory), archetype).first;
 			archetype->insertEntity(eIt->first.m_id);
 
 			m_lookup.find(parentId)->first.m_children.emplace(EntityView { eIt->first.m_id, eIt->first.m_name }); // find parent again because of memory invalidation
@@ -46,26 +125,396 @@ Entity EntityManager::insert(string_view_t name, object_id parentId) {
 	return Entity(nullId, std::numeric_limits<std::size_t>::max(), nullptr);
 }
 
+vector_t<Entity> EntityManager::insert(const Prefab& prefab, std::size_t count) {
+	ETCS_PROFILE_SCOPE("etcs::World::instantiate");
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::instantiate");
+	ETCS_PERF_SCOPE(m_world->m_perfCounters, prefabInstantiation);
+
+	auto arena = m_world->m_memory->arena();
+
+	vector_t<Entity> res;
+	res.reserve(count);
+
+	{ // all temporary id lists live in the arena of the world
+		pmr_vector_t<object_id> ids(arena);
+		insertPrefabRows(prefab, pmr_vector_t<object_id>(arena), count, ids);
+
+		for (auto id : ids) res.emplace_back(Entity(id, std::numeric_limits<std::size_t>::max(), m_world));
+	}
+
+	arena->reset();
+
+	return res;
+}
+
+void EntityManager::insertPrefabRows(const Prefab& prefab, const pmr_vector_t<object_id>& parents, std::size_t count, pmr_vector_t<object_id>& ids) {
+	auto archetype = m_world->m_archetypes.addOrFindArchetype(*prefab.m_archetype);
+
+	ids.reserve(count);
+	while (ids.size() < count) ids.push_back(uniqueId());
+
+	if (parents.empty()) {
+		for (auto id : ids) m_lookup.emplace(EntityData(id, prefab.m_name, m_memory), archetype);
+		archetype->insertEntitiesFromPrefab(ids, *prefab.m_archetype); // every column is filled in one go
+	} else { // every child is grouped with the other children of its parent, the rows of each of these archetypes are inserted at once
+		pmr_vector_t<std::pair<Archetype*, object_id>> rows(ids.get_allocator());
+		rows.reserve(count);
+
+		for (std::size_t i = 0; i < count; i++) {
+			auto childArchetype = m_world->m_archetypes.addOrFindRelation(archetype, lsd::typeId<ChildOf>(), parents[i]);
+			rows.emplace_back(childArchetype, ids[i]);
+
+			auto eIt = m_lookup.emplace(EntityData(ids[i], prefab.m_name, &m_lookup.find(parents[i])->first, m_memory), childArchetype).first;
+			m_lookup.find(parents[i])->first.m_children.emplace(EntityView { eIt->first.m_id, eIt->first.m_name });
+		}
+
+		std::stable_sort(rows.begin(), rows.end(), [](const auto& first, const auto& second) { return first.first < second.first; });
+
+		pmr_vector_t<object_id> rowIds(ids.get_allocator());
+		for (std::size_t begin = 0, end = 0; begin < rows.size(); begin = end) {
+			rowIds.clear();
+			while (end < rows.size() && rows[end].first == rows[begin].first) rowIds.push_back(rows[end++].second);
+
+			rows[begin].first->insertEntitiesFromPrefab(rowIds, *prefab.m_archetype);
+		}
+	}
+
+	for (const auto& child : prefab.m_children) { // children are instantiated level by level for every instance at once
+		pmr_vector_t<object_id> childIds(ids.get_allocator());
+		insertPrefabRows(*child, ids, count, childIds);
+	}
+}
+
+void EntityManager::insertReserved(span_t<const ReservedEntity> entities) {
+	ETCS_PROFILE_SCOPE("etcs::SpawnBuffer::publish");
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::SpawnBuffer::publish");
+
+	auto arena = m_world->m_memory->arena();
+
+	{
+		pmr_vector_t<const ReservedEntity*> instances(arena);
+		auto archetype = m_world->m_archetypes.baseArchetype();
+
+		for (const auto& entity : entities) {
+			if (entity.prefab) instances.push_back(&entity);
+			else {
+				m_lookup.emplace(EntityData(entity.id, entity.name, m_memory), archetype);
+				archetype->insertEntity(entity.id);
+			}
+		}
+
+		std::stable_sort(instances.begin(), instances.end(), [](auto first, auto second) { return first->prefab < second->prefab; });
+
+		for (std::size_t begin = 0, end = 0; begin < instances.size(); begin = end) { // all instances of a prefab are inserted like a single instantiation
+			while (end < instances.size() && instances[end]->prefab == instances[begin]->prefab) end++;
+
+			pmr_vector_t<object_id> ids(arena);
+			ids.reserve(end - begin);
+			for (auto i = begin; i < end; i++) ids.push_back(instances[i]->id);
+
+			insertPrefabRows(*instances[begin]->prefab, pmr_vector_t<object_id>(arena), end - begin, ids);
+		}
+	}
+
+	arena->reset();
+}
+
 void EntityManager::erase(object_id id) {
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::eraseEntity");
+
 	auto e = m_lookup.find(id);
 
 	if (e == m_lookup.end()) throw std::out_of_range("etcs::detail::EntityManager::erase(): Entity ID does not exist!");
 
-	for (auto it = e->first.m_children.begin(); it != e->first.m_children.end(); it++) {
-		m_lookup.find(it->id)->first.m_parent = e->first.m_parent;
+	auto parent = m_lookup.find(e->first.m_parent.id);
+	if (parent != m_lookup.end()) unlinkChild(parent->first, e->first);
+
+	for (auto it = e->first.m_children.begin(); it != e->first.m_children.end(); it++) { // children are handed to the parent, renamed if one of its children already has their name
+		auto& child = m_lookup.find(it->id)->first;
+
+		child.m_parent = e->first.m_parent;
+		if (parent != m_lookup.end()) linkChild(parent->first, child);
+
+		auto index = std::numeric_limits<std::size_t>::max();
+		m_world->updateParent(it->id, index);
 	}
 
+	m_world->releaseTarget(id);
+
+	e->second->eraseEntity(id);
+	m_sparse.erase(id);
+
 	m_unused.push_back(id);
 	m_lookup.erase(id);
 }
 
+void EntityManager::eraseSubtrees(span_t<const Entity> entities) {
+	ETCS_PROFILE_SCOPE("etcs::World::eraseEntities");
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::eraseEntities");
+
+	using id_set = lsd::UnorderedSparseSet<object_id, hash_t<object_id>, std::equal_to<object_id>, allocator_t<object_id>>;
+
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	id_set erased(allocator_t<object_id> { scratch }); // in the order of a depth first search, without the subtrees which were already part of another one
+	pmr_vector_t<object_id> stack(scratch);
+
+	for (const auto& entity : entities) {
+		if (erased.contains(entity.m_id)) continue;
+		
+		auto root = m_lookup.find(entity.m_id);
+		if (root == m_lookup.end()) throw std::out_of_range("etcs::detail::EntityManager::eraseSubtrees(): Entity ID does not exist!");
+
+		stack.push_back(entity.m_id);
+		while (!stack.empty()) {
+			auto id = stack.back();
+			stack.popBack();
+
+			if (!erased.emplace(id).second) continue;
+			for (const auto& child : m_lookup.find(id)->first.m_children) stack.push_back(child.id);
+		}
+	}
+
+	pmr_vector_t<std::pair<Archetype*, object_id>> rows(scratch);
+	rows.reserve(erased.size());
+
+	for (auto id : erased) {
+		auto it = m_lookup.find(id);
+
+		if (!erased.contains(it->first.m_parent.id)) // roots of the subtrees are unlinked from their parents which stay alive
+			if (auto parent = m_lookup.find(it->first.m_parent.id); parent != m_lookup.end()) unlinkChild(parent->first, it->first);
+		
+		rows.emplace_back(it->second, id);
+	}
+
+	std::sort(rows.begin(), rows.end(), [](const auto& first, const auto& second) { return first.first < second.first; });
+
+	{ // every archetype erases all of its rows at once
+		pmr_vector_t<object_id> ids(scratch);
+		ids.reserve(rows.size());
+		for (const auto& row : rows) ids.push_back(row.second);
+
+		for (std::size_t begin = 0, end = 0; begin < rows.size(); begin = end) {
+			while (end < rows.size() && rows[end].first == rows[begin].first) end++;
+			rows[begin].first->eraseEntities(span_t<const object_id>(&ids[begin], end - begin), scratch);
+		}
+	}
+
+	m_unused.reserve(m_unused.size() + erased.size());
+	for (auto id : erased) {
+		m_world->releaseTarget(id); // the entities of the subtrees already left their archetypes, only those outside of them are moved
+
+		m_sparse.erase(id);
+		m_lookup.erase(id);
+
+		m_unused.push_back(id);
+	}
+}
+
+void EntityManager::reparent(span_t<const Entity> entities, object_id parentId) {
+	ETCS_PROFILE_SCOPE("etcs::World::reparent");
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::reparent");
+
+	using id_set = lsd::UnorderedSparseSet<object_id, hash_t<object_id>, std::equal_to<object_id>, allocator_t<object_id>>;
+
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	id_set ancestors(allocator_t<object_id> { scratch }); // the new parent and all of its ancestors, which can't become its children
+	for (auto ancestor = parentId; m_lookup.contains(ancestor); ) {
+		ancestors.emplace(ancestor);
+		ancestor = m_lookup.find(ancestor)->first.m_parent.id;
+	}
+
+	if (ancestors.empty()) throw std::out_of_range("etcs::detail::EntityManager::reparent(): Parent ID does not exist!");
+	for (const auto& entity : entities) 
+		if (ancestors.contains(entity.m_id)) throw std::logic_error("etcs::detail::EntityManager::reparent(): An entity can't become a child of itself or one of its own descendants!");
+
+	for (const auto& entity : entities) {
+		auto& data = this->data(entity.m_id, entity.m_index);
+		if (data.m_parent.id == parentId) continue;
+
+		if (auto parent = m_lookup.find(data.m_parent.id); parent != m_lookup.end()) unlinkChild(parent->first, data);
+
+		auto& parent = m_lookup.find(parentId)->first;
+		data.m_parent = { parent.m_id, parent.m_name };
+		linkChild(parent, data);
+
+		m_world->updateParent(entity.m_id, entity.m_index);
+	}
+}
+
+vector_t<Entity> EntityManager::insertFrom(EntityManager& source, span_t<const Entity> entities) {
+	ETCS_PROFILE_SCOPE("etcs::World::transfer");
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::transfer");
+	ETCS_WRITE_SCOPE(source.m_world->m_access, "etcs::World::transfer"); // the entities are erased from the source
+
+	if (&source == this) throw std::logic_error("etcs::detail::EntityManager::insertFrom(): Entities can't be transferred into the world they are already in!");
+
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	id_table ids(allocator_t<std::pair<object_id, object_id>> { scratch }); // the entities with all of their descendants
+	pmr_vector_t<object_id> stack(scratch);
+
+	for (const auto& entity : entities) {
+		if (!source.m_lookup.contains(entity.m_id)) throw std::out_of_range("etcs::detail::EntityManager::insertFrom(): Entity ID does not exist!");
+
+		stack.push_back(entity.m_id);
+		while (!stack.empty()) {
+			auto id = stack.back();
+			stack.popBack();
+
+			if (!ids.emplace(id, nullId).second) continue;
+			for (const auto& child : source.m_lookup.find(id)->first.m_children) stack.push_back(child.id);
+		}
+	}
+
+	spliceFrom(source, ids);
+
+	vector_t<Entity> res;
+	res.reserve(entities.size());
+
+	for (const auto& entity : entities) res.emplace_back(Entity(ids.find(entity.m_id)->second, std::numeric_limits<std::size_t>::max(), m_world));
+
+	return res;
+}
+
+void EntityManager::insertFrom(EntityManager& source) {
+	ETCS_PROFILE_SCOPE("etcs::World::merge");
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::merge");
+	ETCS_WRITE_SCOPE(source.m_world->m_access, "etcs::World::merge");
+
+	if (&source == this) throw std::logic_error("etcs::detail::EntityManager::insertFrom(): A world can't be merged into itself!");
+
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	id_table ids(allocator_t<std::pair<object_id, object_id>> { scratch });
+	for (const auto& [data, _] : source.m_lookup) ids.emplace(data.m_id, nullId);
+
+	spliceFrom(source, ids);
+}
+
+void EntityManager::spliceFrom(EntityManager& source, id_table& ids) {
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	for (auto& [sourceId, id] : ids) { // all entities are inserted before any view points to their names
+		const auto& sourceData = source.m_lookup.find(sourceId)->first;
+
+		id = uniqueId();
+		m_lookup.emplace(EntityData(id, sourceData.m_name, m_memory), nullptr).first->first.m_depth = sourceData.m_depth;
+	}
+
+	pmr_vector_t<object_id> roots(scratch); // of the moved subtrees, which lose their parents in the source world
+	for (const auto& [sourceId, id] : ids) {
+		auto& sourceData = source.m_lookup.find(sourceId)->first;
+		auto& data = m_lookup.find(id)->first;
+
+		if (auto parent = ids.find(sourceData.m_parent.id); parent != ids.end()) {
+			auto& parentData = m_lookup.find(parent->second)->first;
+
+			data.m_parent = { parentData.m_id, parentData.m_name };
+			parentData.m_children.emplace(EntityView { data.m_id, data.m_name });
+		} else {
+			if (auto sourceParent = source.m_lookup.find(sourceData.m_parent.id); sourceParent != source.m_lookup.end()) source.unlinkChild(sourceParent->first, sourceData);
+			roots.push_back(id);
+		}
+	}
+
+	for (auto id : roots) updateDepth(id, 0);
+
+	{ // all rows of an archetype are moved at once, whole archetypes column by column
+		pmr_vector_t<std::pair<Archetype*, object_id>> rows(scratch);
+		rows.reserve(ids.size());
+
+		for (const auto& [sourceId, _] : ids) rows.emplace_back(source.m_lookup.find(sourceId)->second, sourceId);
+		std::sort(rows.begin(), rows.end(), [](const auto& first, const auto& second) { return first.first < second.first; });
+
+		pmr_vector_t<object_id> sourceIds(scratch), entityIds(scratch);
+		sourceIds.reserve(rows.size());
+		entityIds.reserve(rows.size());
+
+		for (const auto& row : rows) {
+			sourceIds.push_back(row.second);
+			entityIds.push_back(ids.find(row.second)->second);
+		}
+
+		for (std::size_t begin = 0, end = 0; begin < rows.size(); begin = end) {
+			while (end < rows.size() && rows[end].first == rows[begin].first) end++;
+
+			auto archetype = m_world->m_archetypes.addOrFindTranslated(*rows[begin].first, source.m_world->m_archetypes.shared(), ids);
+			archetype->insertEntitiesFrom(*rows[begin].first, span_t<const object_id>(&entityIds[begin], end - begin), span_t<const object_id>(&sourceIds[begin], end - begin), scratch);
+
+			for (auto i = begin; i < end; i++) m_lookup.find(entityIds[i])->second = archetype;
+		}
+	}
+
+	source.m_unused.reserve(source.m_unused.size() + ids.size());
+	for (const auto& [sourceId, id] : ids) {
+		m_sparse.moveFrom(source.m_sparse, sourceId, id);
+
+		source.m_world->releaseTarget(sourceId);
+
+		source.m_lookup.erase(sourceId);
+		source.m_unused.push_back(sourceId);
+	}
+}
+
+void EntityManager::linkChild(EntityData& parent, EntityData& child) {
+	if (parent.m_children.contains(child.m_name.view())) {
+		std::string name(child.m_name.view().data(), child.m_name.view().size());
+		do name += '#' + std::to_string(child.m_id); while (parent.m_children.contains(string_view_t(name.data(), name.size())));
+
+		child.m_name.assign(string_view_t(name.data(), name.size())); // moves the name into a new allocation, so the views of the children are updated
+
+		std::size_t index = 0;
+		for (const auto& grandchild : child.m_children) data(grandchild.id, index).m_parent.name = child.m_name;
+	}
+
+	parent.m_children.emplace(EntityView { child.m_id, child.m_name });
+}
+
+void EntityManager::unlinkChild(EntityData& parent, const EntityData& child) {
+	if (auto it = parent.m_children.find(child.m_name.view()); it != parent.m_children.end() && it->id == child.m_id) parent.m_children.erase(it);
+}
+
+EntityMemoryStats EntityManager::memoryStats() const {
+	EntityMemoryStats stats;
+	stats.entities = m_lookup.size();
+
+	stats.lookupBytes = detail::reservedBytes(m_lookup);
+	stats.lookupBucketBytes = detail::bucketBytes(m_lookup);
+	stats.unusedIdBytes = detail::reservedBytes(m_unused);
+
+	for (const auto& [data, _] : m_lookup) {
+		stats.nameBytes += data.m_name.allocatedBytes();
+		stats.childrenBytes += detail::reservedBytes(data.m_children);
+		stats.childrenBucketBytes += detail::bucketBytes(data.m_children);
+	}
+
+	return stats;
+}
+
 void EntityManager::clear(object_id id) {
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::World::clearEntity");
+
 	auto& archetype = m_lookup.at(id);
+	auto cleared = m_world->m_archetypes.addOrFindRelations(*archetype); // relations and whether the entity is disabled aren't components, so they are kept
+	if (archetype->contains<Disabled>()) cleared = m_world->m_archetypes.addOrFindSuperset<Disabled>(cleared);
+
 	archetype->eraseEntity(id);
-	archetype = m_world->m_archetypes.baseArchetype();
+	cleared->insertEntity(id);
+	archetype = cleared;
+
+	m_sparse.erase(id);
 }
 
 detail::EntityData& EntityManager::data(object_id id, std::size_t& index) {
+	ETCS_PERF_SAMPLE(m_world->m_perfCounters, entityData);
+
 	if (m_lookup.size() > index) if (auto& e = (m_lookup.begin() + index)->first; e.m_id == id) return e;
 	
 	if (auto it = m_lookup.find(id); it != m_lookup.end()) {
@@ -77,6 +526,8 @@ detail::EntityData& EntityManager::data(object_id id, std::size_t& index) {
 }
 
 const detail::EntityData& EntityManager::data(object_id id, std::size_t& index) const {
+	ETCS_PERF_SAMPLE(m_world->m_perfCounters, entityData);
+
 	if (m_lookup.size() > index) if (auto& e = (m_lookup.begin() + index)->first; e.m_id == id) return e;
 	
 	if (auto it = m_lookup.find(id); it != m_lookup.end()) {
@@ -113,6 +564,30 @@ const Archetype* EntityManager::archetype(object_id id, std::size_t& index) cons
 	return m_lookup.begin()->second;
 }
 
+void EntityManager::updateDepth(object_id id, std::size_t depth) {
+	auto scratch = m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	pmr_vector_t<std::pair<object_id, std::size_t>> stack(scratch);
+	stack.emplace_back(id, depth);
+
+	while (!stack.empty()) {
+		auto [entityId, entityDepth] = stack.back();
+		stack.popBack();
+
+		auto it = m_lookup.find(entityId);
+		if (it == m_lookup.end() || it->first.m_depth == entityDepth) continue; // the rest of the subtree is already up to date
+
+		it->first.m_depth = entityDepth;
+		for (const auto& child : it->first.m_children) stack.emplace_back(child.id, entityDepth + 1);
+	}
+}
+
+std::size_t EntityManager::depth(const Archetype& archetype) const {
+	if (auto parent = m_lookup.find(archetype.relationTarget(lsd::typeId<ChildOf>())); parent != m_lookup.end()) return parent->first.m_depth + 1;
+	else return 0;
+}
+
 Entity EntityManager::find(object_id entityId) const {
 	if (auto it = m_lookup.find(entityId); it != m_lookup.end()) return Entity(it->first.m_id, it - m_lookup.begin(), m_world);
 	else throw std::out_of_range("etcs::detail::EntityManager::data(): Entity ID did not exist!");
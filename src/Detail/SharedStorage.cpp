@@ -0,0 +1,77 @@
+#include "../../include/ETCS/Detail/SharedStorage.h"
+
+namespace etcs {
+
+namespace detail {
+
+// BasicSharedPool
+
+void BasicSharedPool::reclaim() {
+	for (auto handle : m_unreferenced) // a handle is listed again whenever it is released or reused
+		if (m_references[handle] == 0 && eraseValue(handle)) m_unused.push_back(handle);
+
+	m_unreferenced.clear();
+}
+
+std::size_t BasicSharedPool::insertHandle() {
+	std::size_t handle;
+
+	if (!m_unused.empty()) {
+		handle = m_unused.back();
+		m_unused.popBack();
+	} else {
+		handle = m_references.size();
+		m_references.push_back(0);
+	}
+
+	m_unreferenced.push_back(handle);
+	return handle;
+}
+
+void BasicSharedPool::copyHandles(const BasicSharedPool& source) {
+	m_unused = source.m_unused;
+
+	m_references.reserve(source.m_references.size());
+	m_unreferenced.reserve(source.m_references.size());
+	for (std::size_t handle = 0; handle < source.m_references.size(); handle++) {
+		m_references.push_back(0);
+		m_unreferenced.push_back(handle);
+	}
+}
+
+
+// SharedStorage
+
+SharedStorage::SharedStorage(const SharedStorage& source, WorldMemory* memory) : m_pools(allocator_t<std::pair<lsd::type_id, pool_handle>>(memory->resource(AllocationTag::columns))), m_memory(memory) {
+	for (const auto& [id, pool] : source.m_pools) m_pools.emplace(id, pool->copy(memory->resource(AllocationTag::columns)));
+}
+
+SharedValue SharedStorage::insertFrom(lsd::type_id typeId, const SharedStorage& source, std::size_t handle) {
+	const auto& sourcePool = *source.m_pools.at(typeId);
+
+	auto& pool = m_pools[typeId];
+	if (!pool) pool = sourcePool.copyType(m_memory->resource(AllocationTag::columns));
+
+	return pool->insertFrom(sourcePool, handle);
+}
+
+void SharedStorage::reclaim() {
+	for (const auto& [_, pool] : m_pools) pool->reclaim();
+}
+
+pmr_vector_t<lsd::type_id> SharedStorage::typeIds(memory_resource* resource) const {
+	pmr_vector_t<lsd::type_id> ids(resource);
+	ids.reserve(m_pools.size());
+
+	for (const auto& [id, _] : m_pools) ids.push_back(id);
+	return ids;
+}
+
+void SharedStorage::memoryStats(WorldMemoryStats& stats) const {
+	stats.sharedBytes = detail::reservedBytes(m_pools) + detail::bucketBytes(m_pools);
+	for (const auto& [_, pool] : m_pools) stats.sharedBytes += pool->size() * pool->elementSize();
+}
+
+} // namespace detail
+
+} // namespace etcs
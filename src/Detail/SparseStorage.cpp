@@ -0,0 +1,119 @@
+#include "../../include/ETCS/Detail/SparseStorage.h"
+
+#include <algorithm>
+
+namespace etcs {
+
+namespace detail {
+
+// BasicSparsePool
+
+BasicSparsePool::BasicSparsePool(const BasicSparsePool& other, memory_resource* resource) :
+	m_ids(other.m_ids, allocator_t<object_id>(resource)),
+	m_pages(allocator_t<std::size_t*>(resource)),
+	m_resource(resource) {
+	m_pages.resize(other.m_pages.size(), nullptr);
+
+	for (std::size_t i = 0; i < m_pages.size(); i++) {
+		if (other.m_pages[i]) {
+			m_pages[i] = static_cast<std::size_t*>(m_resource->allocate(pageSize * sizeof(std::size_t), alignof(std::size_t)));
+			std::copy_n(other.m_pages[i], pageSize, m_pages[i]);
+		}
+	}
+}
+
+BasicSparsePool::~BasicSparsePool() {
+	for (auto page : m_pages) if (page) m_resource->deallocate(page, pageSize * sizeof(std::size_t), alignof(std::size_t));
+}
+
+void BasicSparsePool::insertId(object_id entityId) {
+	auto pageIndex = entityId / pageSize;
+
+	if (pageIndex >= m_pages.size()) m_pages.resize(pageIndex + 1, nullptr);
+
+	auto& page = m_pages[pageIndex];
+	if (!page) {
+		page = static_cast<std::size_t*>(m_resource->allocate(pageSize * sizeof(std::size_t), alignof(std::size_t)));
+		std::fill_n(page, pageSize, nullIndex);
+	} else if (page[entityId % pageSize] != nullIndex) throw std::out_of_range("etcs::detail::BasicSparsePool::insertId(): Entity is already in the sparse pool!");
+
+	page[entityId % pageSize] = m_ids.size();
+	m_ids.push_back(entityId);
+}
+
+void BasicSparsePool::erase(object_id entityId) {
+	auto i = index(entityId);
+	if (i == nullIndex) return;
+
+	auto last = m_ids.back();
+
+	eraseComponent(i);
+
+	m_ids[i] = last;
+	m_ids.pop_back();
+
+	m_pages[last / pageSize][last % pageSize] = i;
+	m_pages[entityId / pageSize][entityId % pageSize] = nullIndex;
+}
+
+std::size_t BasicSparsePool::indexBytes() const noexcept {
+	auto bytes = detail::reservedBytes(m_ids) + detail::reservedBytes(m_pages);
+	for (auto page : m_pages) if (page) bytes += pageSize * sizeof(std::size_t);
+
+	return bytes;
+}
+
+
+// SparseStorage
+
+BasicSparsePool* SparseStorage::find(lsd::type_id typeId) const {
+	if (auto it = m_pools.find(typeId); it != m_pools.end()) return it->second.get();
+	else return nullptr;
+}
+
+BasicSparsePool* SparseStorage::findWritable(lsd::type_id typeId) {
+	if (auto it = m_pools.find(typeId); it != m_pools.end()) return &writable(it->second);
+	else return nullptr;
+}
+
+void SparseStorage::erase(object_id entityId) {
+	for (auto& [_, handle] : m_pools)
+		if (handle->contains(entityId)) writable(handle).erase(entityId);
+}
+
+void SparseStorage::moveFrom(SparseStorage& source, object_id sourceId, object_id entityId) {
+	for (auto& [id, sourceHandle] : source.m_pools) {
+		if (!sourceHandle->contains(sourceId)) continue;
+
+		auto& handle = m_pools[id];
+		if (!handle) handle = sourceHandle->copyType(m_memory->resource(AllocationTag::columns));
+
+		writable(handle).moveFrom(source.writable(sourceHandle), sourceId, entityId);
+	}
+}
+
+void SparseStorage::memoryStats(WorldMemoryStats& stats) const {
+	stats.sparsePools.reserve(m_pools.size());
+
+	stats.sparseBytes = detail::reservedBytes(m_pools) + detail::bucketBytes(m_pools);
+	for (const auto& [id, pool] : m_pools) {
+		const auto& poolStats = stats.sparsePools.emplace_back(ColumnMemoryStats {
+			id,
+			pool->elementSize(),
+			pool->size(),
+			pool->capacity(),
+			pool.shared()
+		});
+
+		stats.sparseBytes += poolStats.reservedBytes() + pool->indexBytes();
+	}
+}
+
+BasicSparsePool& SparseStorage::writable(pool_handle& handle) { // copy on write if the pool is shared with a forked world
+	if (handle.shared()) handle = handle->copy(m_memory->resource(AllocationTag::columns));
+	return *handle;
+}
+
+} // namespace detail
+
+} // namespace etcs
@@ -0,0 +1,181 @@
+#include "../../include/ETCS/Detail/WorldMemory.h"
+
+#include <algorithm>
+
+namespace etcs {
+
+namespace detail {
+
+LinearResource::~LinearResource() {
+	release();
+}
+
+void LinearResource::reset() noexcept {
+	if (!m_blocks) return;
+
+	auto largest = m_blocks;
+	for (auto block = m_blocks->next; block; block = block->next) if (block->size > largest->size) largest = block;
+
+	for (auto block = m_blocks; block;) {
+		auto next = block->next;
+		if (block != largest) m_upstream->deallocate(block, block->size, alignof(std::max_align_t));
+		block = next;
+	}
+
+	largest->next = nullptr;
+	m_blocks = largest;
+	m_current = reinterpret_cast<std::byte*>(largest) + sizeof(Block);
+	m_end = reinterpret_cast<std::byte*>(largest) + largest->size;
+}
+
+void LinearResource::release() noexcept {
+	for (auto block = m_blocks; block;) {
+		auto next = block->next;
+		m_upstream->deallocate(block, block->size, alignof(std::max_align_t));
+		block = next;
+	}
+
+	m_blocks = nullptr;
+	m_current = nullptr;
+	m_end = nullptr;
+}
+
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+
+void TrackingResource::nextFrame() noexcept {
+	m_previousFrameAllocations.store(m_frameAllocations.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+	m_previousFrameBytes.store(m_frameBytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+AllocationStats TrackingResource::stats() const noexcept {
+	return {
+		m_allocations.load(std::memory_order_relaxed),
+		m_deallocations.load(std::memory_order_relaxed),
+		m_bytes.load(std::memory_order_relaxed),
+		m_peakBytes.load(std::memory_order_relaxed),
+		m_frameAllocations.load(std::memory_order_relaxed),
+		m_frameBytes.load(std::memory_order_relaxed),
+		m_previousFrameAllocations.load(std::memory_order_relaxed),
+		m_previousFrameBytes.load(std::memory_order_relaxed)
+	};
+}
+
+void* TrackingResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+	auto p = m_upstream->allocate(bytes, alignment);
+
+	m_allocations.fetch_add(1, std::memory_order_relaxed);
+	m_frameAllocations.fetch_add(1, std::memory_order_relaxed);
+	m_frameBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+	auto current = m_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	for (auto peak = m_peakBytes.load(std::memory_order_relaxed); peak < current && !m_peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed););
+
+	return p;
+}
+
+void TrackingResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+	m_upstream->deallocate(p, bytes, alignment);
+
+	m_deallocations.fetch_add(1, std::memory_order_relaxed);
+	m_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+#endif
+
+
+WorldMemory::WorldMemory(memory_resource* upstream, memory_resource* columns) : m_pool(upstream), m_arena(resource(AllocationTag::temporaries)), m_columns(columns), m_id(++m_idCounter) {
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+	for (auto& tracking : m_tracking) tracking.upstream(&m_pool);
+	m_tracking[static_cast<std::size_t>(AllocationTag::temporaries)].upstream(upstream); // temporaries are allocated in blocks, pooling doesn't help
+#endif
+}
+
+WorldMemory::~WorldMemory() {
+	for (auto slot = m_scratch.load(std::memory_order_acquire); slot;) {
+		auto next = slot->next;
+		delete slot;
+		slot = next;
+	}
+}
+
+void WorldMemory::nextFrame() noexcept {
+	m_frame.fetch_add(1, std::memory_order_release);
+
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+	for (auto& tracking : m_tracking) tracking.nextFrame();
+#endif
+}
+
+#ifdef ETCS_ENABLE_ALLOCATION_TRACKING
+
+WorldAllocationStats WorldMemory::allocationStats() const noexcept {
+	WorldAllocationStats stats;
+	for (std::size_t i = 0; i < stats.size(); i++) stats[i] = m_tracking[i].stats();
+
+	return stats;
+}
+
+#endif
+
+LinearResource* WorldMemory::scratch() {
+	struct CacheEntry {
+		std::size_t world;
+		ScratchSlot* slot;
+	};
+
+	thread_local array_t<CacheEntry, 8> cache { }; // world ids are never reused, so stale entries are never dereferenced
+
+	auto& entry = cache[m_id % cache.size()];
+	if (entry.world != m_id) entry = { m_id, findOrInsertScratch() };
+
+	if (auto frame = m_frame.load(std::memory_order_acquire); entry.slot->frame != frame && !entry.slot->resource.scoped()) { // a nested call must not free the memory of the outer scopes
+		entry.slot->resource.reset();
+		entry.slot->frame = frame;
+	}
+
+	return &entry.slot->resource;
+}
+
+WorldMemory::ScratchSlot* WorldMemory::findOrInsertScratch() {
+	auto thread = std::this_thread::get_id();
+
+	for (auto slot = m_scratch.load(std::memory_order_acquire); slot; slot = slot->next)
+		if (slot->thread == thread) return slot;
+
+	auto slot = new ScratchSlot { LinearResource(resource(AllocationTag::temporaries)), thread, m_frame.load(std::memory_order_acquire), m_scratch.load(std::memory_order_relaxed) };
+	while (!m_scratch.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed));
+
+	return slot;
+}
+
+void* LinearResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+	auto space = static_cast<std::size_t>(m_end - m_current);
+	void* p = m_current;
+
+	if (!m_current || !std::align(alignment, bytes, p, space)) {
+		insertBlock(std::max(m_blockSize, bytes + alignment + sizeof(Block)));
+
+		space = static_cast<std::size_t>(m_end - m_current);
+		p = m_current;
+		std::align(alignment, bytes, p, space);
+	}
+
+	m_current = static_cast<std::byte*>(p) + bytes;
+	return p;
+}
+
+void LinearResource::insertBlock(std::size_t size) {
+	auto block = static_cast<Block*>(m_upstream->allocate(size, alignof(std::max_align_t)));
+	block->next = m_blocks;
+	block->size = size;
+
+	m_blocks = block;
+	m_current = reinterpret_cast<std::byte*>(block) + sizeof(Block);
+	m_end = reinterpret_cast<std::byte*>(block) + size;
+
+	m_blockSize = std::max(m_blockSize, size) * 2; // grow geometrically so a warm arena doesn't need new blocks
+}
+
+} // namespace detail
+
+} // namespace etcs
@@ -8,6 +8,10 @@ void Entity::destroy() noexcept {
 	m_world->m_entities.erase(m_id);
 	m_id = nullId;
 }
+void Entity::destroyRecursive() {
+	m_world->m_entities.eraseSubtrees(span_t<const Entity>(this, 1));
+	m_id = nullId;
+}
 
 
 Entity::iterator Entity::begin() {
@@ -31,12 +35,7 @@ Entity::const_iterator Entity::cend() const {
 }
 
 Entity Entity::insertChild(const Entity& child) const {
-	auto& data = m_world->m_entities.data(m_id, m_index);
-	auto& childData = m_world->m_entities.data(child.m_id, child.m_index);
-	
-	childData.m_parent = { data.m_id, data.m_name };
-	data.m_children.emplace(detail::EntityView { childData.m_id, childData.m_name });
-
+	m_world->m_entities.reparent(span_t<const Entity>(&child, 1), m_id); // cycles are rejected, since the depths of a cycle could never be updated
 	return child;
 }
 Entity Entity::insertChild(string_view_t name) const {
@@ -44,14 +43,17 @@ Entity Entity::insertChild(string_view_t name) const {
 }
 
 Entity& Entity::erase(const_iterator pos) { 
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::Entity::erase");
 	m_world->m_entities.data(m_id, m_index).m_children.erase(pos); 
 	return *this;
 }
 Entity& Entity::erase(const_iterator first, const_iterator last) { 
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::Entity::erase");
 	m_world->m_entities.data(m_id, m_index).m_children.erase(first, last); 
 	return *this;
 }
 Entity& Entity::erase(string_view_t name) { 
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::Entity::erase");
 	m_world->m_entities.data(m_id, m_index).m_children.erase(name); 
 	return *this;
 }
@@ -66,40 +68,59 @@ const Entity& Entity::clearComponents() const {
 }
 
 Entity& Entity::clearChildren() { 
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::Entity::clearChildren");
 	m_world->m_entities.data(m_id, m_index).m_children.clear();
 	return *this;
 }
 
 Entity& Entity::rename(string_view_t name) {
-	std::size_t id = 0;
+	ETCS_WRITE_SCOPE(m_world->m_access, "etcs::Entity::rename");
+
+	std::size_t index = 0;
 
 	auto& data = m_world->m_entities.data(m_id, m_index);
-	auto& parentData = m_world->m_entities.data(data.m_parent.id, id);
+	auto& parentData = m_world->m_entities.data(data.m_parent.id, index);
 
-	parentData.m_children.erase(data.m_name);
-	data.m_name = name;
+	parentData.m_children.erase(data.m_name.view());
+	data.m_name.assign(name); // moves the name into a new allocation, so every view of it is updated
 	parentData.m_children.emplace(detail::EntityView { data.m_id, data.m_name });
 
+	for (const auto& child : data.m_children) m_world->m_entities.data(child.id, index).m_parent.name = data.m_name;
+
 	return *this;
 }
 
 Entity& Entity::enable() {
-	m_world->m_entities.data(m_id, m_index).m_active = true;
+	if (contains<Disabled>()) {
+		m_world->eraseComponent<Disabled>(m_id, m_index);
+		if (!m_world->m_entities.data(m_id, m_index).m_children.empty()) m_world->m_archetypes.invalidateQueries();
+	}
+
 	return *this;
 }
-Entity& Entity::disable() {
-	m_world->m_entities.data(m_id, m_index).m_active = false;
+Entity& Entity::disable() { // a single archetype move, the descendants are skipped by queries through the archetypes of their parents
+	if (!contains<Disabled>()) {
+		m_world->insertComponent<Disabled>(m_id, m_index);
+		if (!m_world->m_entities.data(m_id, m_index).m_children.empty()) m_world->m_archetypes.invalidateQueries(); // existing queries resolve the archetypes of the descendants again
+	}
+
 	return *this;
 }
 
 Entity::iterator Entity::find(string_view_t name) { 
+	ETCS_PERF_SCOPE(m_world->m_perfCounters, entityLookup);
+
 	return m_world->m_entities.data(m_id, m_index).m_children.find(name); 
 }
 Entity::const_iterator Entity::find(string_view_t name) const { 
+	ETCS_PERF_SCOPE(m_world->m_perfCounters, entityLookup);
+
 	return m_world->m_entities.data(m_id, m_index).m_children.find(name); 
 }
 
 bool Entity::contains(string_view_t name) const { 
+	ETCS_PERF_SCOPE(m_world->m_perfCounters, entityLookup);
+
 	return m_world->m_entities.data(m_id, m_index).m_children.contains(name); 
 }
 bool Entity::hasParent() const {
@@ -107,6 +128,8 @@ bool Entity::hasParent() const {
 }
 
 Entity Entity::at(string_view_t name) const {
+	ETCS_PERF_SCOPE(m_world->m_perfCounters, entityLookup);
+
 	std::size_t beg = 0, cur = 0, id = 0;
 	auto p = m_id;
 
@@ -133,7 +156,22 @@ bool Entity::alive() const {
 	return m_world->m_entities.contains(m_id);
 }
 bool Entity::active() const {
-	return m_world->m_entities.data(m_id, m_index).m_active;
+	return !contains<Disabled>();
+}
+bool Entity::activeInHierarchy() const {
+	if (!active()) return false;
+
+	for (auto ancestor = m_world->m_entities.data(m_id, m_index).m_parent.id; m_world->m_entities.contains(ancestor); ) {
+		std::size_t index = std::numeric_limits<std::size_t>::max();
+		if (m_world->m_entities.archetype(ancestor, index)->contains<Disabled>()) return false;
+
+		ancestor = m_world->m_entities.data(ancestor, index).m_parent.id;
+	}
+
+	return true;
+}
+std::size_t Entity::depth() const {
+	return m_world->m_entities.data(m_id, m_index).m_depth;
 }
 
 bool Entity::hasComponents() const { 
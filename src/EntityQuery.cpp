@@ -3,6 +3,7 @@
 #include "../include/ETCS/World.h"
 #include "../include/ETCS/Entity.h"
 
+#include <functional>
 #include <limits>
 
 namespace etcs {
@@ -13,13 +14,43 @@ namespace detail {
 
 BasicQueryIterator::BasicQueryIterator(BasicEntityQuery* query, archetype_it iterator, archetype_const_it end, entity_it entityIterator) : 
 	m_iterator(iterator), m_end(end), m_entityIterator(entityIterator), m_query(query) {
+#ifdef ETCS_ENABLE_PROFILING
+	m_profileBegin = profileTimestamp();
+#endif
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+	m_perfBegin = readPerfCounters();
+#endif
+
+	skipInvalid();
+}
+
+BasicQueryIterator::BasicQueryIterator(BasicEntityQuery* query, const BasicSparsePool& pool) : 
+	m_iterator(query->m_archetypes.begin()), m_end(query->m_archetypes.end()), m_pool(&pool), m_poolIndex(pool.size()), m_query(query) {
+#ifdef ETCS_ENABLE_PROFILING
+	m_profileBegin = profileTimestamp();
+#endif
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+	m_perfBegin = readPerfCounters();
+#endif
+
 	skipInvalid();
 }
 
 Entity BasicQueryIterator::entity() {
+	if (m_indexed != m_entityIterator) { // entities created together usually lie next to each other in the lookup, so the slot after the previous entity is tried before hashing
+		m_entityIndex++;
+		static_cast<void>(std::as_const(m_query->world()->m_entities).archetype(*m_entityIterator, m_entityIndex));
+
+		m_indexed = m_entityIterator;
+	}
+
 	return Entity(*m_entityIterator, m_entityIndex, m_query->world());
 }
 
+Entity BasicQueryIterator::relationTarget(lsd::type_id relation) {
+	return Entity((*m_iterator)->relationTarget(relation), std::numeric_limits<std::size_t>::max(), m_query->world());
+}
+
 BasicQueryIterator& BasicQueryIterator::operator++() {
 	incrementIterator();
 	skipInvalid();
@@ -28,26 +59,262 @@ BasicQueryIterator& BasicQueryIterator::operator++() {
 }
 
 void BasicQueryIterator::incrementIterator() {
-	if (m_iterator != m_end && ++m_entityIterator >= (*m_iterator)->m_entities.end() && ++m_iterator != m_end)
-		m_entityIterator = (*m_iterator)->m_entities.begin();
+	if (m_pool) {
+		if (m_poolIndex != 0) m_poolIndex--;
+	} else if (m_iterator != m_end && ++m_entityIterator >= (*m_iterator)->m_entities.end()) nextArchetype();
+}
+
+void BasicQueryIterator::nextArchetype() {
+	recordIteration("etcs::EntityQuery::iterateArchetype"); // every archetype is recorded on its own, since the end of the whole iteration is unknown
+
+	if (++m_iterator != m_end) m_entityIterator = (*m_iterator)->m_entities.begin();
+}
+
+void BasicQueryIterator::recordIteration(const char* event) {
+#ifdef ETCS_ENABLE_PROFILING
+	auto timestamp = profileTimestamp();
+	recordProfileEvent(event, m_profileBegin, timestamp);
+	m_profileBegin = timestamp;
+#else
+	(void)event;
+#endif
+#ifdef ETCS_ENABLE_PERF_COUNTERS // attributed both to the world and to the query itself
+	auto counters = readPerfCounters();
+	auto difference = counters - m_perfBegin;
+
+	m_query->m_world->m_perfCounters.add(PerfOperation::queryIteration, difference);
+	m_query->m_perfCounters.calls++;
+	m_query->m_perfCounters.values += difference;
+
+	m_perfBegin = counters;
+#endif
 }
 
 void BasicQueryIterator::skipInvalid() {
-	while (
-		m_iterator != m_end && // if the archetype iterator is at the end, don't increment
-		!m_query->world()->m_entities.data((*m_entityIterator), m_entityIndex).m_active // check if the entity is active
-	) incrementIterator();
+	if (m_pool) {
+		skipPooled();
+		return;
+	}
+
+	while (m_iterator != m_end) { // if the archetype iterator is at the end, don't increment
+		if (m_entityIterator == (*m_iterator)->m_entities.end()) nextArchetype(); // the archetype was emptied after the query was constructed
+		else if (!m_query->matchesSparse(*m_entityIterator)) incrementIterator(); // disabled entities are already excluded per archetype, only components in sparse pools are checked per entity
+		else break;
+	}
+}
+
+void BasicQueryIterator::skipPooled() {
+	const auto& indices = m_query->m_archetypeIndices;
+	const auto& entities = std::as_const(m_query->world()->m_entities);
+
+	for (m_poolIndex = std::min(m_poolIndex, m_pool->size()); m_poolIndex != 0; m_poolIndex--) { // the current entity may have erased components of the pool
+		auto id = m_pool->ids()[m_poolIndex - 1];
+		if (!m_query->matchesSparse(id)) continue;
+
+		auto entityIndex = std::numeric_limits<std::size_t>::max();
+		auto archetype = entities.archetype(id, entityIndex);
+
+		auto it = std::lower_bound(indices.begin(), indices.end(), archetype, [](const auto& entry, const Archetype* archetype) { return std::less<const Archetype*>()(entry.first, archetype); });
+		if (it == indices.end() || it->first != archetype) continue; // excluded by the archetype terms or disabled
+
+		m_iterator = m_query->m_archetypes.begin() + it->second;
+		m_entityIterator = (*m_iterator)->m_entities.find(id);
+		m_indexed = m_entityIterator;
+		m_entityIndex = entityIndex;
+
+		return;
+	}
+
+	recordIteration("etcs::EntityQuery::iteratePool");
+	m_iterator = m_query->m_archetypes.end();
 }
 
 
 // BasicEntityQuery
 
-BasicEntityQuery::BasicEntityQuery(WorldData* world, const vector_t<lsd::type_id>& typeIds) : m_world(world) {
-	world->m_archetypes.querySupersets(m_archetypes, typeIds);
+BasicEntityQuery::BasicEntityQuery(WorldData* world, const QueryFilter& filter, QueryOrder order, const RelationFilter& target) : 
+	m_memory(world->m_memory), 
+	m_archetypes(world->m_memory->resource(AllocationTag::queries)), 
+	m_optionalMasks(world->m_memory->resource(AllocationTag::queries)), 
+	m_sparsePools(world->m_memory->resource(AllocationTag::queries)), 
+	m_archetypeIndices(world->m_memory->resource(AllocationTag::queries)), 
+	m_filter(filter), 
+	m_target(target), 
+	m_order(order), 
+	m_world(world) {
+	collect();
+}
+
+void BasicEntityQuery::collect() {
+	ETCS_PROFILE_SCOPE("etcs::EntityQuery::construct");
+	ETCS_PERF_SCOPE(m_world->m_perfCounters, queryConstruction);
+
+	m_archetypes.clear();
+	m_optionalMasks.clear();
+	m_sparsePools.clear();
+	m_archetypeIndices.clear();
+	m_generation = m_world->m_archetypes.generation();
+
+	if (m_target.target != nullId) m_world->m_archetypes.queryRelated(m_archetypes, m_filter, m_target.target);
+	else m_world->m_archetypes.querySupersets(m_archetypes, m_filter);
+
+	if (!m_filter.relations.empty() || m_target.relation != lsd::type_id { }) { // all entities of an archetype have the same targets, so they are only checked once
+		std::size_t count = 0;
+		for (auto archetype : m_archetypes) {
+			if (
+				matchesRelation(*archetype, m_target) && 
+				std::all_of(m_filter.relations.begin(), m_filter.relations.end(), [this, archetype](const auto& relation) { return matchesRelation(*archetype, relation); })
+			) m_archetypes[count++] = archetype;
+		}
+
+		m_archetypes.resize(count);
+	}
+
+	auto disabledId = lsd::typeId<Disabled>();
+	if (std::find(m_filter.required.begin(), m_filter.required.end(), disabledId) == m_filter.required.end() && std::find(m_filter.optional.begin(), m_filter.optional.end(), disabledId) == m_filter.optional.end()) 
+		eraseDisabled();
+
+	if (m_order == QueryOrder::depth) sortByDepth();
+
+	if (!m_filter.sparse.empty()) { // pools are resolved once, only their entities are checked while iterating
+		m_sparsePools.reserve(m_filter.sparse.size());
+		m_sparseRequired = m_filter.sparseRequired;
+		m_sparseExcluded = m_filter.sparseExcluded;
+
+		auto& storage = m_world->m_entities.sparse();
+		for (std::size_t i = 0; i < m_filter.sparse.size(); i++) {
+			auto pool = m_filter.sparseWritable[i] ? storage.findWritable(m_filter.sparse[i]) : storage.find(m_filter.sparse[i]);
+			if (!pool && i < m_sparseRequired) { // no entity can match
+				m_archetypes.clear();
+				return;
+			}
+
+			m_sparsePools.push_back(pool);
+		}
+
+		if (m_sparseRequired != 0 && m_order == QueryOrder::archetype) { // the order of a pool doesn't follow the hierarchy
+			m_archetypeIndices.reserve(m_archetypes.size());
+			for (std::size_t i = 0; i < m_archetypes.size(); i++) m_archetypeIndices.emplace_back(m_archetypes[i], i);
+
+			std::sort(m_archetypeIndices.begin(), m_archetypeIndices.end(), [](const auto& first, const auto& second) { return std::less<const Archetype*>()(first.first, second.first); });
+		}
+	}
+
+	if (!m_filter.optional.empty()) {
+		m_optionalMasks.reserve(m_archetypes.size());
+
+		for (auto archetype : m_archetypes) {
+			std::uint64_t mask = 0;
+			for (std::size_t i = 0; i < m_filter.optional.size(); i++) 
+				if (archetype->contains(m_filter.optional[i])) mask |= (std::uint64_t(1) << i);
+
+			m_optionalMasks.push_back(mask);
+		}
+	}
+}
+
+void BasicEntityQuery::refresh() {
+	if (m_world && m_generation != m_world->m_archetypes.generation()) collect();
+}
+
+const BasicSparsePool* BasicEntityQuery::smallerPool() const noexcept {
+	if (m_archetypeIndices.empty()) return nullptr;
+
+	auto pool = *std::min_element(m_sparsePools.begin(), m_sparsePools.begin() + m_sparseRequired, [](auto first, auto second) { return first->size() < second->size(); });
+
+	std::size_t rows = 0;
+	for (auto archetype : m_archetypes) rows += archetype->m_entities.size();
+
+	return pool->size() < rows ? pool : nullptr;
+}
+
+void BasicEntityQuery::eraseDisabled() { // entities whose parent is disabled are all in the archetypes with the parent as target, so whole subtrees are skipped at once
+	using disabled_map = lsd::UnorderedSparseMap<const Archetype*, bool, hash_t<const Archetype*>, std::equal_to<const Archetype*>, allocator_t<std::pair<const Archetype*, bool>>>;
+
+	auto scratch = m_world->m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	auto allocator = allocator_t<std::pair<const Archetype*, bool>>(scratch);
+	disabled_map disabled(allocator); // resolved archetypes, so every chain of ancestors is only walked once
+	pmr_vector_t<const Archetype*> path(scratch);
+
+	auto isDisabled = [&](const Archetype* archetype) {
+		auto res = false;
+
+		for (auto current = archetype; current; ) {
+			if (auto it = disabled.find(current); it != disabled.end()) {
+				res = it->second;
+				break;
+			}
+
+			path.push_back(current);
+
+			if (current->contains<Disabled>()) {
+				res = true;
+				break;
+			}
+
+			auto parent = current->relationTarget(lsd::typeId<ChildOf>()), index = std::numeric_limits<std::size_t>::max();
+			current = m_world->m_entities.contains(parent) ? std::as_const(m_world->m_entities).archetype(parent, index) : nullptr;
+		}
+
+		for (auto resolved : path) disabled.emplace(resolved, res);
+		path.clear();
+
+		return res;
+	};
+
+	std::size_t count = 0;
+	for (auto archetype : m_archetypes) if (!isDisabled(archetype)) m_archetypes[count++] = archetype;
+
+	m_archetypes.resize(count);
+}
+
+void BasicEntityQuery::sortByDepth() { // all entities of an archetype share their parent, so sorting the archetypes orders the entities as well
+	auto scratch = m_world->m_memory->scratch();
+	LinearResource::Scope scope(scratch);
+
+	pmr_vector_t<std::pair<std::size_t, Archetype*>> depths(scratch);
+	depths.reserve(m_archetypes.size());
+
+	for (auto archetype : m_archetypes) depths.emplace_back(m_world->m_entities.depth(*archetype), archetype);
+	std::stable_sort(depths.begin(), depths.end(), [](const auto& first, const auto& second) { return first.first < second.first; });
+
+	for (std::size_t i = 0; i < depths.size(); i++) m_archetypes[i] = depths[i].second;
+}
+
+bool BasicEntityQuery::matchingEntities(const Archetype& archetype, pmr_vector_t<object_id>& entityIds) const {
+	entityIds.reserve(archetype.m_entities.size());
+	for (auto id : archetype.m_entities) if (matchesSparse(id)) entityIds.push_back(id);
+
+	return entityIds.size() == archetype.m_entities.size();
+}
+
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+void BasicEntityQuery::checkWrites(span_t<const ComponentAccess> components) const {
+	m_world->m_access.checkQuery(components);
+}
+#endif
+
+bool BasicEntityQuery::matchesRelation(const Archetype& archetype, const RelationFilter& filter) const {
+	if (filter.relation == lsd::type_id { }) return true;
+
+	auto target = archetype.relationTarget(filter.relation);
+	if (target == nullId || (filter.target != nullId && target != filter.target)) return false;
+	if (filter.targetComponents.empty()) return true;
+	if (!m_world->m_entities.contains(target)) return false;
+
+	auto index = std::numeric_limits<std::size_t>::max();
+	auto targetArchetype = std::as_const(m_world->m_entities).archetype(target, index);
+
+	return std::all_of(filter.targetComponents.begin(), filter.targetComponents.end(), [targetArchetype](auto id) { return targetArchetype->contains(id); });
 }
 
 BasicQueryIterator BasicEntityQuery::begin() {
+	refresh();
+
 	if (m_archetypes.empty()) return BasicQueryIterator();
+	else if (auto pool = smallerPool()) return BasicQueryIterator(this, *pool); // e.g. only sparse terms, where the archetypes hold every entity of the world
 	else return BasicQueryIterator(this, m_archetypes.begin(), m_archetypes.end(), (*m_archetypes.begin())->m_entities.begin());
 }
 
@@ -0,0 +1,168 @@
+#include "../include/ETCS/PageResource.h"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace etcs {
+
+PageResource::~PageResource() {
+	while (m_chunks) {
+		auto next = m_chunks->next;
+		unmap(m_chunks, chunkSize(), pageSize);
+		m_chunks = next;
+	}
+}
+
+std::size_t PageResource::chunkCount() const noexcept {
+	std::lock_guard lock(m_mutex);
+
+	std::size_t count = 0;
+	for (auto chunk = m_chunks; chunk; chunk = chunk->next) count++;
+
+	return count;
+}
+
+void* PageResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+	if (auto size = blockSize(bytes, alignment); size != 0) {
+		auto& freeBlocks = m_freeBlocks[std::countr_zero(size) - std::countr_zero(minBlockSize)];
+
+		std::lock_guard lock(m_mutex);
+
+		if (auto block = freeBlocks; block) {
+			freeBlocks = block->next;
+			return block;
+		}
+
+		return carve(size);
+	}
+
+	return map(mappingSize(bytes), alignment);
+}
+
+void PageResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+	if (auto size = blockSize(bytes, alignment); size != 0) { // kept for the next allocation of the same size until the resource is destroyed
+		auto& freeBlocks = m_freeBlocks[std::countr_zero(size) - std::countr_zero(minBlockSize)];
+
+		std::lock_guard lock(m_mutex);
+		freeBlocks = ::new (p) FreeBlock { freeBlocks };
+	} else unmap(p, mappingSize(bytes), alignment);
+}
+
+std::size_t PageResource::blockSize(std::size_t bytes, std::size_t alignment) const noexcept {
+	auto size = std::bit_ceil(std::max({ bytes, alignment, minBlockSize }));
+	return (size <= chunkSize() / 8 && alignment <= pageSize) ? size : 0;
+}
+
+void* PageResource::carve(std::size_t size) {
+	auto alignment = std::min(size, pageSize); // chunks are page aligned, so every block is aligned to its size up to a page
+	auto aligned = (reinterpret_cast<std::uintptr_t>(m_current) + alignment - 1) & ~(alignment - 1);
+
+	if (!m_current || aligned + size > reinterpret_cast<std::uintptr_t>(m_end)) { // the rest of the previous chunk is left unused
+		auto chunk = static_cast<std::byte*>(map(chunkSize(), pageSize));
+
+		m_chunks = ::new (chunk) FreeBlock { m_chunks };
+		m_current = chunk + minBlockSize;
+		m_end = chunk + chunkSize();
+
+		aligned = (reinterpret_cast<std::uintptr_t>(m_current) + alignment - 1) & ~(alignment - 1);
+	}
+
+	m_current = reinterpret_cast<std::byte*>(aligned + size);
+	return reinterpret_cast<void*>(aligned);
+}
+
+#ifdef __linux__
+
+namespace {
+
+// values of the memory policy modes from linux/mempolicy.h, mbind is called directly to not depend on libnuma
+constexpr int policyPreferred = 1;
+constexpr int policyBind = 2;
+
+} // namespace
+
+int PageResource::currentNode() noexcept {
+	unsigned cpu = 0, node = 0;
+	if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return anyNode;
+
+	return static_cast<int>(node);
+}
+
+void* PageResource::map(std::size_t size, std::size_t alignment) {
+	auto hugePages = m_hugePages && size >= hugePageSize;
+	auto mappingAlignment = std::max(alignment, hugePages ? hugePageSize : pageSize);
+
+	// map more than needed if the kernel can't be trusted to return a suitably aligned address and trim the rest
+	auto reserved = size + ((mappingAlignment > pageSize) ? mappingAlignment : 0);
+
+	auto mapping = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) throw std::bad_alloc();
+
+	auto begin = reinterpret_cast<std::uintptr_t>(mapping);
+	auto aligned = (begin + mappingAlignment - 1) & ~(mappingAlignment - 1);
+
+	if (aligned != begin) munmap(mapping, aligned - begin);
+	if (auto end = aligned + size; end != begin + reserved) munmap(reinterpret_cast<void*>(end), begin + reserved - end);
+
+	auto p = reinterpret_cast<void*>(aligned);
+
+	// both of these are only hints, the memory stays usable if the kernel doesn't support them
+	if (hugePages) madvise(p, size, MADV_HUGEPAGE);
+
+	if (m_node != anyNode) {
+		unsigned long mask[4] = { };
+		constexpr auto maskBits = sizeof(mask) * 8;
+
+		if (static_cast<std::size_t>(m_node) < maskBits) {
+			mask[m_node / (sizeof(unsigned long) * 8)] |= 1ul << (m_node % (sizeof(unsigned long) * 8));
+
+			if (syscall(SYS_mbind, p, size, m_strictNode ? policyBind : policyPreferred, mask, maskBits, 0) != 0 && m_strictNode) {
+				munmap(p, size);
+				throw std::bad_alloc();
+			}
+		}
+	}
+
+	return p;
+}
+
+void PageResource::unmap(void* p, std::size_t size, std::size_t) noexcept {
+	munmap(p, size);
+}
+
+std::size_t PageResource::mappingSize(std::size_t bytes) const noexcept {
+	// only allocations which fill at least half of a huge page are worth rounding up
+	auto granularity = (m_hugePages && bytes >= hugePageSize / 2) ? hugePageSize : pageSize;
+	return (bytes + granularity - 1) & ~(granularity - 1);
+}
+
+#else
+
+int PageResource::currentNode() noexcept {
+	return anyNode;
+}
+
+void* PageResource::map(std::size_t size, std::size_t alignment) {
+	return ::operator new(size, std::align_val_t(alignment));
+}
+
+void PageResource::unmap(void* p, std::size_t size, std::size_t alignment) noexcept {
+	::operator delete(p, size, std::align_val_t(alignment));
+}
+
+std::size_t PageResource::mappingSize(std::size_t bytes) const noexcept {
+	return bytes;
+}
+
+#endif
+
+} // namespace etcs
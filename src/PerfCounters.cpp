@@ -0,0 +1,148 @@
+#include "../include/ETCS/PerfCounters.h"
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace etcs {
+
+#ifdef __linux__
+
+namespace {
+
+// one counter group per thread, opened on first use and closed when the thread exits
+class ThreadCounters {
+public:
+	ThreadCounters() {
+		m_leader = open(PERF_COUNT_HW_INSTRUCTIONS, -1);
+		if (m_leader < 0) return;
+
+		m_members[0] = open(PERF_COUNT_HW_CACHE_MISSES, m_leader);
+		m_members[1] = open(PERF_COUNT_HW_BRANCH_MISSES, m_leader);
+
+		if (m_members[0] < 0 || m_members[1] < 0) {
+			close();
+			return;
+		}
+
+		ioctl(PERF_EVENT_IOC_RESET);
+		ioctl(PERF_EVENT_IOC_ENABLE);
+	}
+	ThreadCounters(const ThreadCounters&) = delete;
+	~ThreadCounters() {
+		close();
+	}
+
+	ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+	[[nodiscard]] PerfCounterValues read() const noexcept {
+		if (m_leader < 0) return { };
+
+		struct {
+			std::uint64_t count;
+			std::uint64_t values[3];
+		} group { };
+
+		if (::read(m_leader, &group, sizeof(group)) != sizeof(group)) return { };
+		return { group.values[0], group.values[1], group.values[2] };
+	}
+	[[nodiscard]] bool valid() const noexcept {
+		return m_leader >= 0;
+	}
+
+private:
+	int m_leader = -1;
+	int m_members[2] = { -1, -1 };
+
+	static int open(std::uint64_t config, int group) noexcept {
+		perf_event_attr attributes { };
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.size = sizeof(attributes);
+		attributes.config = config;
+		attributes.disabled = (group < 0); // the leader enables the whole group at once
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_GROUP;
+
+		return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, group, 0));
+	}
+
+	void ioctl(unsigned long request) const noexcept {
+		::ioctl(m_leader, request, PERF_IOC_FLAG_GROUP);
+	}
+	void close() noexcept {
+		for (auto& member : m_members) if (member >= 0) ::close(member);
+		if (m_leader >= 0) ::close(m_leader);
+
+		m_leader = -1;
+		m_members[0] = m_members[1] = -1;
+	}
+};
+
+const ThreadCounters& threadCounters() {
+	thread_local ThreadCounters counters;
+	return counters;
+}
+
+} // namespace
+
+bool perfCountersAvailable() {
+	return threadCounters().valid();
+}
+
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+
+namespace detail {
+
+PerfCounterValues readPerfCounters() noexcept {
+	return threadCounters().read();
+}
+
+} // namespace detail
+
+#endif
+
+#else
+
+bool perfCountersAvailable() {
+	return false;
+}
+
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+
+namespace detail {
+
+PerfCounterValues readPerfCounters() noexcept {
+	return { };
+}
+
+} // namespace detail
+
+#endif
+
+#endif
+
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+
+namespace detail {
+
+std::size_t& perfScopeDepth() noexcept {
+	thread_local std::size_t depth = 0;
+	return depth;
+}
+
+bool perfSampleDue() noexcept {
+	thread_local std::uint64_t calls = 0;
+	return perfScopeDepth() == 0 && ++calls % perfSampleRate == 0; // calls nested in a scope are already attributed to it
+}
+
+} // namespace detail
+
+#endif
+
+} // namespace etcs
@@ -0,0 +1,117 @@
+#include "../include/ETCS/Profiler.h"
+
+#ifdef ETCS_ENABLE_PROFILING
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+
+#endif
+
+namespace etcs {
+
+#ifdef ETCS_ENABLE_PROFILING
+
+namespace {
+
+struct Event {
+	const char* name;
+	std::uint64_t begin;
+	std::uint64_t end;
+};
+
+// only ever written by its own thread, once full the oldest events are overwritten
+struct ThreadBuffer {
+	static constexpr std::size_t capacity = 1 << 16;
+
+	array_t<Event, capacity> events;
+
+	std::atomic<std::uint64_t> head = 0; // number of events ever recorded
+	std::atomic<std::uint64_t> tail = 0; // events before this were cleared
+
+	std::size_t thread;
+	ThreadBuffer* next;
+};
+
+std::atomic<ThreadBuffer*> buffers = nullptr;
+std::atomic<std::size_t> threadCounter = 0;
+
+const auto epoch = std::chrono::steady_clock::now();
+
+ThreadBuffer& threadBuffer() {
+	// buffers are never freed, since the events of a thread should still be exported after it exited
+	thread_local ThreadBuffer* buffer = [] {
+		auto buffer = new ThreadBuffer;
+		buffer->thread = threadCounter.fetch_add(1, std::memory_order_relaxed);
+		buffer->next = buffers.load(std::memory_order_relaxed);
+
+		while (!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed));
+
+		return buffer;
+	}();
+
+	return *buffer;
+}
+
+} // namespace
+
+namespace detail {
+
+std::uint64_t profileTimestamp() noexcept {
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void recordProfileEvent(const char* name, std::uint64_t begin, std::uint64_t end) noexcept {
+	auto& buffer = threadBuffer();
+	auto head = buffer.head.load(std::memory_order_relaxed);
+
+	buffer.events[head % ThreadBuffer::capacity] = { name, begin, end };
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+void writeChromeTrace(std::ostream& stream) {
+	auto flags = stream.flags();
+	auto precision = stream.precision();
+
+	stream << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+
+	auto first = true;
+	for (auto buffer = buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+		auto head = buffer->head.load(std::memory_order_acquire);
+		auto begin = std::max(buffer->tail.load(std::memory_order_relaxed), (head > ThreadBuffer::capacity) ? head - ThreadBuffer::capacity : 0);
+
+		for (auto i = begin; i < head; i++) {
+			const auto& event = buffer->events[i % ThreadBuffer::capacity];
+
+			stream << (first ? "\n" : ",\n") <<
+				"{\"name\":\"" << event.name << "\",\"cat\":\"etcs\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread <<
+				",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+			first = false;
+		}
+	}
+
+	stream << "\n]}\n";
+
+	stream.flags(flags);
+	stream.precision(precision);
+}
+
+void clearProfile() {
+	for (auto buffer = buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next)
+		buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+#else
+
+void writeChromeTrace(std::ostream& stream) {
+	stream << "{\"traceEvents\":[]}\n";
+}
+
+void clearProfile() { }
+
+#endif
+
+} // namespace etcs
@@ -0,0 +1,78 @@
+#include "../include/ETCS/SpawnBuffer.h"
+
+#include <utility>
+
+namespace etcs {
+
+SpawnBuffer::SpawnBuffer(SpawnBuffer&& other) noexcept : 
+	m_world(other.m_world), 
+	m_entities(std::move(other.m_entities)), 
+	m_next(std::exchange(other.m_next, nullId)), 
+	m_end(std::exchange(other.m_end, nullId)) { 
+	other.m_entities.clear();
+}
+
+SpawnBuffer::~SpawnBuffer() {
+	release();
+}
+
+SpawnBuffer& SpawnBuffer::operator=(SpawnBuffer&& other) {
+	if (this != &other) {
+		release();
+
+		m_world = other.m_world;
+		m_entities = std::move(other.m_entities);
+		m_next = std::exchange(other.m_next, nullId);
+		m_end = std::exchange(other.m_end, nullId);
+
+		other.m_entities.clear();
+	}
+
+	return *this;
+}
+
+Entity SpawnBuffer::spawn(string_view_t name) {
+	auto id = reserveId();
+	m_entities.push_back(detail::ReservedEntity { id, nullptr, string_t(name) });
+
+	return Entity(id, std::numeric_limits<std::size_t>::max(), m_world.m_data);
+}
+
+Entity SpawnBuffer::spawn(const Prefab& prefab) {
+	auto id = reserveId();
+	m_entities.push_back(detail::ReservedEntity { id, &prefab, { } });
+
+	return Entity(id, std::numeric_limits<std::size_t>::max(), m_world.m_data);
+}
+
+void SpawnBuffer::publish() {
+	auto& entities = m_world.m_data->m_entities;
+
+	entities.insertReserved(span_t<const detail::ReservedEntity>(m_entities.begin().get(), m_entities.size()));
+	m_entities.clear();
+
+	release(); // otherwise the ids would never be used if the buffer isn't published again
+}
+
+object_id SpawnBuffer::reserveId() {
+	if (m_next == m_end) {
+		m_next = m_world.m_data->m_entities.reserveIds(blockSize);
+		m_end = m_next + blockSize;
+	}
+
+	return m_next++;
+}
+
+void SpawnBuffer::release() {
+	if (m_entities.empty() && m_next == m_end) return;
+
+	auto& entities = m_world.m_data->m_entities;
+
+	for (const auto& entity : m_entities) entities.releaseIds(entity.id, 1);
+	m_entities.clear();
+
+	if (m_next != m_end) entities.releaseIds(m_next, m_end - m_next);
+	m_next = m_end = nullId;
+}
+
+} // namespace etcs
@@ -0,0 +1,57 @@
+#include "../include/ETCS/StagedWorld.h"
+
+#include "../include/ETCS/Profiler.h"
+
+#include <utility>
+
+namespace etcs {
+
+// StagedWorld
+
+StagedWorld::StagedWorld(string_view_t name, memory_resource* upstream) : m_data(unique_ptr_t<detail::WorldData>::create(name, upstream)) { }
+StagedWorld::StagedWorld(World target, string_view_t name) : m_data(unique_ptr_t<detail::WorldData>::create(name, target.m_data->m_memory)) { }
+
+
+// WorldHandoff
+
+void WorldHandoff::push(StagedWorld&& world) {
+	std::lock_guard lock(m_mutex);
+	m_pending.push_back(std::move(world));
+}
+
+std::size_t WorldHandoff::mergeInto(World target) {
+	ETCS_PROFILE_SCOPE("etcs::WorldHandoff::mergeInto");
+
+	auto worlds = take();
+	for (auto& world : worlds) {
+		auto staged = std::move(world); // freed as soon as it was merged instead of after all of them
+		target.merge(staged.world());
+	}
+
+	return worlds.size();
+}
+
+std::size_t WorldHandoff::publish() {
+	ETCS_PROFILE_SCOPE("etcs::WorldHandoff::publish");
+
+	auto worlds = take();
+	for (auto& world : worlds) publishWorld(std::move(world));
+
+	return worlds.size();
+}
+
+bool WorldHandoff::empty() const {
+	std::lock_guard lock(m_mutex);
+	return m_pending.empty();
+}
+
+vector_t<StagedWorld> WorldHandoff::take() {
+	vector_t<StagedWorld> worlds;
+
+	std::lock_guard lock(m_mutex);
+	std::swap(worlds, m_pending);
+
+	return worlds;
+}
+
+} // namespace etcs
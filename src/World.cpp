@@ -1,39 +1,179 @@
 #include "../include/ETCS/World.h"
+#include "../include/ETCS/StagedWorld.h"
 
 #include <LSD/UnorderedSparseSet.h>
 
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+
 #include "../include/ETCS/Detail/WorldData.h"
 
 namespace etcs {
 
 namespace detail {
 
-class WorldManager {
+class WorldManager { // lookups by name share the lock, handles are checked through the generation of their slot without locking at all
+private:
+	struct Slot {
+		unique_ptr_t<WorldData> data;
+		std::atomic<std::uint32_t> generation = 0; // incremented whenever the world of the slot is erased, which invalidates all of its handles
+		std::atomic<std::uint32_t> pins = 0; // forks copying the world without holding the lock, it is only destroyed once all of them finished
+	};
+
+	class Pin { // keeps the world of a slot alive after the lock was released
+	public:
+		Pin(Slot& slot) : m_slot(slot) {
+			m_slot.pins.fetch_add(1, std::memory_order_relaxed); // the lock is held, so it can't be erased in the meantime
+		}
+		Pin(const Pin&) = delete;
+		~Pin() {
+			if (m_slot.pins.fetch_sub(1, std::memory_order_release) == 1) m_slot.pins.notify_all();
+		}
+
+		Pin& operator=(const Pin&) = delete;
+
+	private:
+		Slot& m_slot;
+	};
+
 public:
+	static constexpr std::size_t maxWorlds = 4096; // slots never move, so a handle can be checked while another thread inserts a world
+
 	WorldManager() {
-		m_worlds.emplace(new WorldData({ }));
+		insert(unique_ptr_t<WorldData>::create(string_view_t { }));
 	}
 
 	World world(string_view_t name) const {
-		return World(m_worlds.at(name).get());
+		std::shared_lock lock(m_mutex);
+		return World(m_worlds.at(name));
 	}
 
-	World insert(string_view_t name) {
-		if (m_worlds.contains(name)) return World(m_worlds.at(name).get());
-		else return World((*m_worlds.emplace(new WorldData(name)).first).get());
+	World insert(string_view_t name, memory_resource* upstream) {
+		std::unique_lock lock(m_mutex);
+
+		if (auto it = m_worlds.find(name); it != m_worlds.end()) return World(*it);
+		else return insertSlot(unique_ptr_t<WorldData>::create(name, upstream));
+	}
+	World insert(unique_ptr_t<WorldData>&& data) {
+		std::unique_lock lock(m_mutex);
+
+		if (m_worlds.contains(data->m_name)) throw std::logic_error("etcs::publishWorld(): A world with the requested name already exists!");
+		else return insertSlot(std::move(data));
+	}
+
+	World fork(const World& source, string_view_t name) {
+		ETCS_PROFILE_SCOPE("etcs::World::fork");
+
+		std::optional<Pin> pin; // the source can't be erased while it is copied, but the lock isn't held during the copy
+		unique_ptr_t<WorldData> data; // destroyed after the lock was released if the name was taken in the meantime
+
+		if (source.m_slot != std::numeric_limits<std::size_t>::max()) { // staged worlds aren't registered
+			std::shared_lock lock(m_mutex);
+
+			if (!contains(source.m_slot, source.m_generation)) throw std::out_of_range("etcs::forkWorld(): The source world was already erased!");
+			if (m_worlds.contains(name)) throw std::logic_error("etcs::forkWorld(): A world with the requested name already exists!");
+
+			pin.emplace(m_slots[source.m_slot]);
+		}
+
+		{
+			AccessReader reader; // structural changes of the source conflict with the copy, or wait for it with write access
+			source.m_data->m_access.lockRead(reader, "etcs::forkWorld");
+
+			try {
+				data = unique_ptr_t<WorldData>::create(*source.m_data, name);
+			} catch (...) {
+				source.m_data->m_access.unlockRead(reader);
+				throw;
+			}
+
+			source.m_data->m_access.unlockRead(reader);
+		}
+
+		std::unique_lock lock(m_mutex); // only held to insert the copy
+
+		if (m_worlds.contains(name)) throw std::logic_error("etcs::forkWorld(): A world with the requested name already exists!");
+		else return insertSlot(std::move(data));
 	}
 
 	void erase(string_view_t name) {
 		if (name == string_view_t { }) throw std::logic_error("etcs::eraseWorld(): Can't erase a world with an empty name, which is the default world!");
-		else m_worlds.erase(name);
+
+		unique_ptr_t<WorldData> data; // destroyed after the lock was released
+
+		{
+			std::unique_lock lock(m_mutex);
+
+			if (auto it = m_worlds.find(name); it != m_worlds.end()) data = eraseSlot(lock, (*it)->m_slot);
+		}
+	}
+	void erase(std::size_t slot, std::uint32_t generation) {
+		if (slot == 0) throw std::logic_error("etcs::eraseWorld(): Can't erase the default world!");
+
+		unique_ptr_t<WorldData> data; // destroyed after the lock was released
+
+		{
+			std::unique_lock lock(m_mutex);
+
+			if (contains(slot, generation)) data = eraseSlot(lock, slot);
+		}
 	}
 
 	bool contains(string_view_t name) const {
+		std::shared_lock lock(m_mutex);
 		return m_worlds.contains(name);
 	}
+	bool contains(std::size_t slot, std::uint32_t generation) const noexcept {
+		return slot < maxWorlds && m_slots[slot].generation.load(std::memory_order_acquire) == generation;
+	}
 
 private:
-	lsd::UnorderedSparseSet<unique_ptr_t<WorldData>, WorldData::Hasher, WorldData::Equal> m_worlds;
+	lsd::UnorderedSparseSet<WorldData*, WorldData::Hasher, WorldData::Equal> m_worlds; // by name
+	
+	array_t<Slot, maxWorlds> m_slots;
+	vector_t<std::size_t> m_unusedSlots;
+	std::size_t m_slotCount = 0; // slots which were ever used
+
+	mutable std::shared_mutex m_mutex;
+
+	World insertSlot(unique_ptr_t<WorldData>&& data) {
+		std::size_t slot;
+
+		if (!m_unusedSlots.empty()) {
+			slot = m_unusedSlots.back();
+			m_unusedSlots.popBack();
+		} else if (m_slotCount < maxWorlds) slot = m_slotCount++;
+		else throw std::runtime_error("etcs::detail::WorldManager::insert(): Current world count exceeded max world count!");
+
+		data->m_slot = slot;
+		data->m_generation = m_slots[slot].generation.load(std::memory_order_relaxed);
+
+		auto world = World(data.get());
+		m_worlds.emplace(data.get());
+		m_slots[slot].data = std::move(data);
+
+		return world;
+	}
+	unique_ptr_t<WorldData> eraseSlot(std::unique_lock<std::shared_mutex>& lock, std::size_t slot) {
+		auto& erased = m_slots[slot];
+
+		erased.generation.fetch_add(1, std::memory_order_release); // no fork can pin the slot anymore
+		m_worlds.erase(erased.data->m_name);
+
+		if (erased.pins.load(std::memory_order_acquire) != 0) { // waits for the forks copying the world, without blocking all other worlds
+			lock.unlock();
+			for (auto pins = erased.pins.load(std::memory_order_acquire); pins != 0; pins = erased.pins.load(std::memory_order_acquire)) erased.pins.wait(pins, std::memory_order_acquire);
+			lock.lock();
+		}
+
+		auto data = std::move(erased.data);
+		m_unusedSlots.push_back(slot);
+
+		return data;
+	}
 };
 
 static WorldManager* globalWorldManager;
@@ -46,7 +186,8 @@ void init() {
 }
 
 void quit() {
-	if (detail::globalWorldManager) delete detail::globalWorldManager;
+	delete detail::globalWorldManager;
+	detail::globalWorldManager = nullptr;
 }
 
 World world(string_view_t name) {
@@ -54,7 +195,19 @@ World world(string_view_t name) {
 }
 
 World insertWorld(string_view_t name) {
-	return detail::globalWorldManager->insert(name);
+	return detail::globalWorldManager->insert(name, std::pmr::get_default_resource());
+}
+
+World insertWorld(string_view_t name, memory_resource* upstream) {
+	return detail::globalWorldManager->insert(name, upstream);
+}
+
+World publishWorld(StagedWorld&& world) {
+	return detail::globalWorldManager->insert(std::move(world.m_data));
+}
+
+World forkWorld(World source, string_view_t name) {
+	return detail::globalWorldManager->fork(source, name);
 }
 
 void eraseWorld(string_view_t name) {
@@ -62,7 +215,7 @@ void eraseWorld(string_view_t name) {
 }
 
 void eraseWorld(World world) {
-	detail::globalWorldManager->erase(world.name());
+	detail::globalWorldManager->erase(world.m_slot, world.m_generation);
 }
 
 bool containsWorld(string_view_t name) {
@@ -70,7 +223,7 @@ bool containsWorld(string_view_t name) {
 }
 
 bool containsWorld(World world) {
-	return detail::globalWorldManager->contains(world.name());
+	return detail::globalWorldManager->contains(world.m_slot, world.m_generation);
 }
 
 } // namespace etcs
@@ -0,0 +1,26 @@
+#include "../include/ETCS/WorldAccess.h"
+
+namespace etcs {
+
+// ReadAccess
+
+ReadAccess::ReadAccess(World world) : m_world(world) {
+	m_world.m_data->m_access.lockRead(m_reader);
+}
+
+ReadAccess::~ReadAccess() {
+	m_world.m_data->m_access.unlockRead(m_reader);
+}
+
+
+// WriteAccess
+
+WriteAccess::WriteAccess(World world) : m_world(world) {
+	m_world.m_data->m_access.lockWrite();
+}
+
+WriteAccess::~WriteAccess() {
+	m_world.m_data->m_access.unlockWrite();
+}
+
+} // namespace etcs
@@ -0,0 +1,134 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+using namespace etcs;
+
+template <std::size_t Index> struct Tag { };
+
+namespace {
+
+constexpr std::size_t tagCount = 72; // more tags than bits in a hash, so the hashes of some of them always cancel out
+
+using tags = std::bitset<tagCount>;
+
+template <std::size_t... Indices> auto tagFunctions(std::index_sequence<Indices...>) { // tags are chosen at runtime, once their hashes are known
+	struct Functions {
+		std::array<void(*)(Entity&), tagCount> insert;
+		std::array<void(*)(Entity&), tagCount> erase;
+		std::array<bool(*)(const Entity&), tagCount> contains;
+	};
+
+	return Functions {
+		{ [](Entity& entity) { entity.insertComponent<Tag<Indices>>(); }... },
+		{ [](Entity& entity) { entity.erase<Tag<Indices>>(); }... },
+		{ [](const Entity& entity) { return entity.contains<Tag<Indices>>(); }... }
+	};
+}
+
+const auto functions = tagFunctions(std::make_index_sequence<tagCount>());
+
+std::size_t singleEntityHash(World world) { // of the only archetype with exactly one entity
+	for (const auto& archetype : world.memoryStats().archetypes) if (archetype.entities == 1) return archetype.hash;
+	return 0;
+}
+
+} // namespace
+
+ETCS_TEST(collidingHashesStayDistinct) {
+	auto world = insertWorld("archetype_colliding_hashes");
+
+	std::array<std::uint64_t, tagCount> hashes { }; // what each tag contributes to the hash of an archetype
+	{
+		auto entity = world.insertEntity();
+		auto base = singleEntityHash(world);
+
+		for (std::size_t i = 0; i < tagCount; i++) {
+			functions.insert[i](entity);
+			hashes[i] = singleEntityHash(world) ^ base;
+			functions.erase[i](entity);
+		}
+
+		entity.destroy();
+	}
+
+	tags colliding; // tags whose hashes xor to zero, found by gaussian elimination
+	{
+		std::array<std::pair<std::uint64_t, tags>, 64> basis { };
+
+		for (std::size_t i = 0; i < tagCount && colliding.none(); i++) {
+			auto value = hashes[i];
+			tags combination;
+			combination.set(i);
+
+			for (std::size_t bit = 64; bit-- > 0 && value != 0; ) {
+				if (!((value >> bit) & 1)) continue;
+
+				if (basis[bit].first == 0) {
+					basis[bit] = { value, combination };
+					break;
+				}
+
+				value ^= basis[bit].first;
+				combination ^= basis[bit].second;
+			}
+
+			if (value == 0) colliding = combination;
+		}
+	}
+
+	ETCS_CHECK(colliding.count() >= 2);
+
+	tags firstTags, secondTags; // any split of the colliding tags has the same hash on both sides
+	for (std::size_t i = 0; i < tagCount; i++) {
+		if (!colliding.test(i)) continue;
+
+		if (firstTags.none()) firstTags.set(i);
+		else secondTags.set(i);
+	}
+
+	auto parent = world.insertEntity();
+	auto first = parent.insertChild("first");
+	auto second = parent.insertChild("second");
+
+	for (std::size_t i = 0; i < tagCount; i++) {
+		if (firstTags.test(i)) functions.insert[i](first);
+		if (secondTags.test(i)) functions.insert[i](second);
+	}
+
+	auto checkTags = [&] {
+		for (std::size_t i = 0; i < tagCount; i++) {
+			ETCS_CHECK(functions.contains[i](first) == firstTags.test(i));
+			ETCS_CHECK(functions.contains[i](second) == secondTags.test(i));
+		}
+	};
+
+	checkTags();
+
+	std::size_t sharedHash = 0;
+	auto stats = world.memoryStats();
+	for (const auto& archetype : stats.archetypes) {
+		if (archetype.entities != 1 || archetype.tags == 0) continue; // the parent is alone in the base archetype
+
+		if (sharedHash == 0) sharedHash = archetype.hash;
+		else ETCS_CHECK(archetype.hash == sharedHash); // the two distinct archetypes really have the same hash
+	}
+
+	parent.destroy(); // both children move into the archetypes without the relation, which collide as well
+	checkTags();
+
+	world.nextFrame(); // destroys both released archetypes, one of which was only stored as a collision
+	checkTags();
+
+	for (const auto& archetype : world.memoryStats().archetypes) ETCS_CHECK(archetype.relations == 0);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST_MAIN()
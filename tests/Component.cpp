@@ -0,0 +1,58 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+
+#include <stdexcept>
+
+using namespace etcs;
+
+struct Position { 
+	float x = 0, y = 0; 
+};
+struct Status { 
+	int stacks = 0; 
+};
+template <> struct etcs::ComponentTraits<Status> { 
+	static constexpr auto storage = ComponentStorage::sparse; 
+};
+
+ETCS_TEST(sparseGet) {
+	auto world = insertWorld("component_sparse_get");
+
+	auto with = world.insertEntity();
+	with.insertComponent<Status>(Status { 3 });
+
+	auto view = with.component<Status>();
+	ETCS_CHECK(view.get().stacks == 3);
+	ETCS_CHECK(std::as_const(view).get().stacks == 3);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(sparseGetMissing) {
+	auto world = insertWorld("component_sparse_missing");
+
+	auto without = world.insertEntity();
+	const auto beforePool = without.component<Status>();
+	ETCS_CHECK_THROWS((void)beforePool.get(), std::out_of_range); // the pool doesn't exist yet
+
+	world.insertEntity().insertComponent<Status>();
+
+	auto view = without.component<Status>();
+	ETCS_CHECK_THROWS((void)std::as_const(view).get(), std::out_of_range); // the pool exists, but doesn't contain the entity
+	ETCS_CHECK_THROWS((void)view.get(), std::out_of_range);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(archetypeGetMissing) {
+	auto world = insertWorld("component_archetype_missing");
+
+	auto without = world.insertEntity();
+	const auto view = without.component<Position>();
+	ETCS_CHECK_THROWS((void)view.get(), std::out_of_range);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST_MAIN()
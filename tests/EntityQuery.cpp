@@ -0,0 +1,127 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/EntityQuery.h>
+
+#include <optional>
+
+using namespace etcs;
+
+struct Position { 
+	float x = 0, y = 0; 
+};
+struct Status { 
+	int stacks = 0; 
+};
+template <> struct etcs::ComponentTraits<Status> { 
+	static constexpr auto storage = ComponentStorage::sparse; 
+};
+
+ETCS_TEST(queryOutlivesWorld) {
+	std::optional<EntityQuery<Position>> query;
+
+	{
+		auto world = insertWorld("entity_query_outlived");
+		for (int i = 0; i < 64; i++) world.insertEntity().insertComponent<Position>();
+
+		query.emplace(world.query<Position>());
+
+		std::size_t count = 0;
+		for (auto [position] : *query) {
+			position.x = 1;
+			count++;
+		}
+		ETCS_CHECK(count == 64);
+
+		eraseWorld(world);
+	}
+
+	query.reset(); // frees its archetype list into the memory of the erased world, which it kept alive
+}
+
+ETCS_TEST(disableAfterIteration) { // disabling moves an entity into another archetype, so entities are only collected while iterating and disabled afterwards
+	auto world = insertWorld("entity_query_disable");
+
+	for (int i = 0; i < 8; i++) {
+		auto parent = world.insertEntity();
+		parent.insertComponent<Position>(Position { static_cast<float>(i), 0 });
+		parent.insertChild("child").insertComponent<Position>(Position { static_cast<float>(i), 1 });
+	}
+
+	auto query = world.query<Entity, const Position>();
+
+	vector_t<Entity> disabled;
+	std::size_t visited = 0;
+	for (auto [entity, position] : query) {
+		if (position.y == 0 && static_cast<int>(position.x) % 2 == 0) disabled.push_back(entity);
+		visited++;
+	}
+	ETCS_CHECK(visited == 16);
+
+	for (auto& entity : disabled) entity.disable();
+
+	visited = 0;
+	for (auto [entity, position] : query) { // constructed before, the archetypes of the children are resolved again
+		ETCS_CHECK(static_cast<int>(position.x) % 2 == 1);
+		ETCS_CHECK(entity.activeInHierarchy());
+		visited++;
+	}
+	ETCS_CHECK(visited == 8);
+
+	for (auto& entity : disabled) entity.enable();
+
+	visited = 0;
+	for (auto [entity, position] : query) {
+		ETCS_CHECK(entity.component<Position>().get().x == position.x);
+		visited++;
+	}
+	ETCS_CHECK(visited == 16);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(sparseQueryVisitsPool) { // the pool is smaller than the archetypes, so only its entities are visited
+	auto world = insertWorld("entity_query_sparse_pool");
+
+	for (int i = 0; i < 256; i++) {
+		auto entity = world.insertEntity();
+		entity.insertComponent<Position>(Position { static_cast<float>(i), 0 });
+		if (i % 16 == 0) entity.insertComponent<Status>(Status { i });
+	}
+	for (int i = 0; i < 4; i++) world.insertEntity().insertComponent<Status>(Status { 1000 + i });
+
+	auto count = [](auto&& query) {
+		std::size_t count = 0;
+		for (auto&& values : query) {
+			(void)values;
+			count++;
+		}
+		return count;
+	};
+
+	std::size_t visited = 0;
+	for (auto [entity, status] : world.query<Entity, const Status>()) {
+		ETCS_CHECK(entity.component<Status>().get().stacks == status.stacks);
+		visited++;
+	}
+	ETCS_CHECK(visited == 20);
+
+	for (auto [position, status] : world.query<const Position, const Status>()) ETCS_CHECK(static_cast<int>(position.x) == status.stacks);
+	ETCS_CHECK(count(world.query<const Position, const Status>()) == 16);
+	ETCS_CHECK(count(world.query<Without<Position>, const Status>()) == 4);
+
+	world.query<Entity, const Status>().begin().entity().disable(); // only the archetypes decide if an entity of the pool is visited
+	ETCS_CHECK(count(world.query<const Status>()) == 19);
+
+	visited = 0;
+	for (auto [entity, status] : world.query<Entity, const Status>()) { // the pool is walked backwards, so erasing the current entity doesn't skip another one
+		entity.erase<Status>();
+		visited++;
+	}
+	ETCS_CHECK(visited == 19);
+	ETCS_CHECK(count(world.query<const Status>()) == 0);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST_MAIN()
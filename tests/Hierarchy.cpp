@@ -0,0 +1,57 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+
+#include <string>
+
+using namespace etcs;
+
+ETCS_TEST(eraseRenamesCollidingChildren) {
+	auto world = insertWorld("hierarchy_erase_collision");
+
+	auto root = world.insertEntity("root");
+	auto kept = root.insertChild("item");
+	auto middle = root.insertChild("middle");
+	auto moved = middle.insertChild("item");
+	auto grandchild = moved.insertChild("leaf");
+
+	world.eraseEntity(middle);
+
+	auto renamed = "item#" + std::to_string(moved.id());
+
+	ETCS_CHECK(root.at("item").id() == kept.id());
+	ETCS_CHECK(root.at(renamed).id() == moved.id());
+	ETCS_CHECK(moved.name() == renamed);
+	ETCS_CHECK(moved.parent().id() == root.id());
+	ETCS_CHECK(grandchild.parent().name() == renamed);
+	ETCS_CHECK(root.at(renamed + "::leaf").id() == grandchild.id());
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(reparentRenamesCollidingEntities) {
+	auto world = insertWorld("hierarchy_reparent_collision");
+
+	auto parent = world.insertEntity("parent");
+	auto existing = parent.insertChild("child");
+	auto other = world.insertEntity("other");
+	auto first = other.insertChild("child");
+
+	world.reparent(span_t<const Entity>(&first, 1), parent);
+
+	ETCS_CHECK(parent.at("child").id() == existing.id());
+	ETCS_CHECK(parent.at("child#" + std::to_string(first.id())).id() == first.id());
+	ETCS_CHECK(other.size() == 0);
+
+	auto unnamed = world.insertEntity();
+	auto second = world.insertEntity();
+	parent.insertChild(unnamed);
+	parent.insertChild(second); // both have the empty name
+
+	ETCS_CHECK(parent.at("#" + std::to_string(second.id())).id() == second.id());
+	ETCS_CHECK(unnamed.parent().id() == parent.id());
+
+	eraseWorld(world);
+}
+
+ETCS_TEST_MAIN()
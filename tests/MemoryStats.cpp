@@ -0,0 +1,190 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/MemoryStats.h>
+#include <ETCS/Detail/WorldMemory.h>
+
+#include <string>
+
+using namespace etcs;
+
+struct Position { 
+	float x = 0, y = 0; 
+};
+struct Velocity { 
+	float x = 0, y = 0; 
+};
+struct Status { 
+	int stacks = 0; 
+};
+template <> struct etcs::ComponentTraits<Status> { 
+	static constexpr auto storage = ComponentStorage::sparse; 
+};
+struct Material { 
+	int shader = 0; 
+	bool operator==(const Material&) const = default; 
+};
+template <> struct etcs::ComponentTraits<Material> { 
+	static constexpr auto storage = ComponentStorage::shared; 
+};
+template <> struct std::hash<Material> { 
+	std::size_t operator()(const Material& material) const noexcept { 
+		return std::hash<int>()(material.shader); 
+	} 
+};
+
+ETCS_TEST(emptyWorld) {
+	auto world = insertWorld("memory_stats_empty");
+	auto stats = world.memoryStats();
+
+	ETCS_CHECK(stats.entities.entities == 0);
+	ETCS_CHECK(stats.entities.nameBytes == 0);
+	ETCS_CHECK(stats.usedBytes == 0);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(populatedWorld) {
+	auto world = insertWorld("memory_stats_populated");
+
+	std::size_t names = 0;
+	for (int i = 0; i < 100; i++) {
+		auto name = "p" + std::to_string(i); // short enough for a small buffer, but still allocated out of line
+		auto parent = world.insertEntity(name);
+		names += name.size();
+
+		parent.insertComponent<Position>(Position { float(i), 0 });
+		if (i % 2 == 0) parent.insertComponent<Velocity>();
+		if (i % 5 == 0) parent.insertComponent<Status>(Status { i });
+		parent.insertComponent<Material>(Material { i % 3 });
+
+		for (int j = 0; j < 3; j++) {
+			auto childName = "child_with_a_name_longer_than_any_small_buffer_" + std::to_string(j);
+			parent.insertChild(childName).insertComponent<Position>();
+			names += childName.size();
+		}
+	}
+
+	auto stats = world.memoryStats();
+
+	ETCS_CHECK(stats.entities.entities == 400);
+	ETCS_CHECK(stats.entities.nameBytes == names);
+	ETCS_CHECK(stats.entities.lookupBytes > 0 && stats.entities.lookupBucketBytes > 0);
+	ETCS_CHECK(stats.entities.childrenBytes > 0 && stats.entities.childrenBucketBytes > 0);
+
+	std::size_t positions = 0;
+	for (const auto& archetype : stats.archetypes) {
+		ETCS_CHECK(archetype.reservedBytes >= archetype.usedBytes);
+		ETCS_CHECK(archetype.entities == 0 || archetype.bucketBytes > 0);
+
+		for (const auto& column : archetype.columns) {
+			ETCS_CHECK(column.size == archetype.entities);
+			ETCS_CHECK(column.capacity >= column.size);
+			if (column.type == lsd::typeId<Position>()) positions += column.size;
+		}
+	}
+	ETCS_CHECK(positions == 400);
+
+	ETCS_CHECK(stats.sparsePools.size() == 1 && stats.sparsePools[0].size == 20);
+	ETCS_CHECK(stats.sparseBytes >= stats.sparsePools[0].usedBytes());
+	ETCS_CHECK(stats.sharedBytes > 0);
+	ETCS_CHECK(stats.archetypeTableBytes > 0);
+	ETCS_CHECK(stats.totalBytes() > stats.reservedBytes + stats.entities.totalBytes());
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(renameAndErase) {
+	auto world = insertWorld("memory_stats_rename");
+
+	auto parent = world.insertEntity("parent");
+	auto child = parent.insertChild("c");
+	child.rename("renamed");
+
+	ETCS_CHECK(world.memoryStats().entities.nameBytes == 6 + 7);
+
+	child.destroy();
+	ETCS_CHECK(world.memoryStats().entities.nameBytes == 6);
+	ETCS_CHECK(world.memoryStats().entities.entities == 1);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(sharedValuesReclaimed) { // values without entities are destroyed with their archetypes at the next frame
+	auto world = insertWorld("memory_stats_shared_values");
+
+	vector_t<Entity> entities;
+	for (int i = 0; i < 4; i++) {
+		auto entity = world.insertEntity();
+		entity.insertComponent<Position>();
+		entity.insertComponent<Material>(Material { i });
+		entities.push_back(entity);
+	}
+
+	auto sharedArchetypes = [&world] {
+		std::size_t count = 0;
+		for (const auto& archetype : world.memoryStats().archetypes) if (archetype.sharedComponents != 0) count++;
+		return count;
+	};
+
+	world.nextFrame();
+	auto before = world.memoryStats();
+	ETCS_CHECK(sharedArchetypes() == 4);
+
+	for (int frame = 1; frame <= 64; frame++) {
+		for (int i = 0; i < 4; i++) entities[i].setSharedComponent<Material>(Material { frame * 4 + i });
+		world.nextFrame();
+
+		ETCS_CHECK(sharedArchetypes() == 4);
+	}
+
+	for (int i = 0; i < 4; i++) ETCS_CHECK(entities[i].component<Material>().get().shader == 256 + i);
+
+	auto after = world.memoryStats();
+	ETCS_CHECK(after.sharedBytes == before.sharedBytes);
+	ETCS_CHECK(after.archetypes.size() == before.archetypes.size());
+
+	entities[0].setSharedComponent<Material>(Material { 257 }); // equal values still share their archetype
+	world.nextFrame();
+	ETCS_CHECK(sharedArchetypes() == 3);
+	ETCS_CHECK(world.memoryStats().sharedBytes < before.sharedBytes);
+
+	for (auto& entity : entities) entity.destroy();
+	world.nextFrame();
+	ETCS_CHECK(sharedArchetypes() == 0);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(scratchKeptWhileScoped) { // a frame passing while a scope is still active doesn't rewind the memory it uses
+	static test::CountingResource upstream;
+	detail::WorldMemory memory(&upstream);
+
+	auto scratch = memory.scratch();
+	{
+		detail::LinearResource::Scope scope(scratch);
+
+		auto outer = static_cast<int*>(scratch->allocate(sizeof(int) * 16, alignof(int)));
+		for (int i = 0; i < 16; i++) outer[i] = i;
+
+		memory.nextFrame();
+
+		{
+			auto nested = memory.scratch();
+			detail::LinearResource::Scope nestedScope(nested);
+
+			auto inner = static_cast<int*>(nested->allocate(sizeof(int) * 16, alignof(int)));
+			for (int i = 0; i < 16; i++) inner[i] = -1;
+		}
+
+		for (int i = 0; i < 16; i++) ETCS_CHECK(outer[i] == i);
+
+		static_cast<void>(scratch->allocate(64 * 1024, alignof(std::max_align_t))); // needs another block, which leaving the scope doesn't free
+	}
+
+	auto bytes = upstream.bytes();
+	static_cast<void>(memory.scratch()); // the reset skipped while the scope was active happens at the first use outside of it
+	ETCS_CHECK(upstream.bytes() < bytes);
+}
+
+ETCS_TEST_MAIN()
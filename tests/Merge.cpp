@@ -0,0 +1,118 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/EntityQuery.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+using namespace etcs;
+
+struct Position {
+	float x = 0, y = 0;
+};
+struct Health {
+	int value = 0;
+};
+struct Material {
+	int shader = 0;
+	std::string texture;
+
+	bool operator==(const Material&) const = default;
+};
+
+template <> struct etcs::ComponentTraits<Health> {
+	static constexpr auto storage = ComponentStorage::sparse;
+};
+template <> struct etcs::ComponentTraits<Material> {
+	static constexpr auto storage = ComponentStorage::shared;
+};
+template <> struct std::hash<Material> {
+	std::size_t operator()(const Material& material) const noexcept {
+		return std::hash<std::string>()(material.texture) ^ static_cast<std::size_t>(material.shader);
+	}
+};
+
+namespace {
+
+vector_t<Entity> populate(World world, std::size_t count) {
+	vector_t<Entity> entities;
+	for (std::size_t i = 0; i < count; i++) {
+		auto entity = world.insertEntity("entity_with_a_name_long_enough_to_be_allocated_" + std::to_string(i));
+		entity.insertComponent<Position>(Position { static_cast<float>(i), -1 });
+		entity.insertComponent<Health>(Health { static_cast<int>(i) });
+		entity.insertComponent<Material>(Material { 1, "texture_name_long_enough_to_be_allocated" });
+		entity.insertChild("child").insertComponent<Position>(Position { 0, static_cast<float>(i) });
+
+		entities.push_back(entity);
+	}
+
+	return entities;
+}
+
+float positionSum(World world) {
+	float sum = 0;
+	for (auto [position] : world.query<const Position>()) sum += position.x + position.y;
+	return sum;
+}
+
+} // namespace
+
+ETCS_TEST(mergeReleasesSourceMemory) {
+	static test::CountingResource upstream; // outlives the world if a check fails before it is erased
+
+	auto target = insertWorld("merge_release_target");
+	auto source = insertWorld("merge_release_source", &upstream);
+
+	populate(source, 64);
+	auto expected = positionSum(source);
+	target.merge(source);
+
+	ETCS_CHECK(source.memoryStats().entities.entities == 0);
+	eraseWorld(source);
+	ETCS_CHECK(upstream.bytes() == 0); // nothing in the target refers to the memory of the source
+
+	ETCS_CHECK(positionSum(target) == expected);
+
+	std::size_t healthSum = 0, materials = 0;
+	for (auto [entity, position] : target.query<Entity, const Position>()) {
+		if (position.y != -1) continue; // only the roots have the other components
+
+		healthSum += entity.component<Health>().get().value;
+		if (entity.component<Material>().get().texture == "texture_name_long_enough_to_be_allocated") materials++;
+	}
+	ETCS_CHECK(healthSum == 63 * 64 / 2);
+	ETCS_CHECK(materials == 64);
+
+	eraseWorld(target);
+}
+
+ETCS_TEST(transferReleasesSourceMemory) {
+	static test::CountingResource upstream; // outlives the world if a check fails before it is erased
+
+	auto target = insertWorld("transfer_release_target");
+	auto source = insertWorld("transfer_release_source", &upstream);
+	auto entities = populate(source, 16);
+
+	vector_t<Entity> roots;
+	for (std::size_t i = 0; i < entities.size(); i += 2) roots.push_back(entities[i]);
+
+	auto moved = source.transfer(span_t<const Entity>(roots.data(), roots.size()), target);
+	ETCS_CHECK(moved.size() == roots.size());
+	ETCS_CHECK(source.memoryStats().entities.entities == 16);
+
+	eraseWorld(source);
+	ETCS_CHECK(upstream.bytes() == 0);
+
+	for (std::size_t i = 0; i < moved.size(); i++) {
+		ETCS_CHECK(moved[i].name() == "entity_with_a_name_long_enough_to_be_allocated_" + std::to_string(i * 2));
+		ETCS_CHECK(moved[i].component<Position>().get().x == static_cast<float>(i * 2));
+		ETCS_CHECK(moved[i].component<Health>().get().value == static_cast<int>(i * 2));
+		ETCS_CHECK(moved[i].at("child").component<Position>().get().y == static_cast<float>(i * 2));
+	}
+
+	eraseWorld(target);
+}
+
+ETCS_TEST_MAIN()
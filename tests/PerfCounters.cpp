@@ -0,0 +1,58 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/PerfCounters.h>
+
+using namespace etcs;
+
+#ifdef ETCS_ENABLE_PERF_COUNTERS
+
+ETCS_TEST(nestedScopesCountOnce) {
+	detail::PerfCounterTable table;
+
+	{
+		detail::PerfScope outer(table, PerfOperation::prefabInstantiation);
+		detail::PerfScope inner(table, PerfOperation::componentInsertion);
+	}
+	{
+		detail::PerfScope single(table, PerfOperation::componentInsertion);
+	}
+
+	auto counters = table.snapshot();
+	ETCS_CHECK(counters[static_cast<std::size_t>(PerfOperation::prefabInstantiation)].calls == 1);
+	ETCS_CHECK(counters[static_cast<std::size_t>(PerfOperation::componentInsertion)].calls == 1);
+}
+
+ETCS_TEST(lookupsByName) {
+	auto world = insertWorld("perf_counters_lookups");
+
+	auto root = world.insertEntity("root");
+	root.insertChild("a").insertChild("b");
+
+	world.resetPerfCounters();
+
+	ETCS_CHECK(root.at("a::b").name() == "b");
+	ETCS_CHECK(root.contains("a"));
+	ETCS_CHECK(root.at("a").parent().id() == root.id()); // lookups by id aren't counted
+
+	ETCS_CHECK(world.perfCounters()[static_cast<std::size_t>(PerfOperation::entityLookup)].calls == 3);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(dataLookupsSampled) {
+	auto world = insertWorld("perf_counters_data");
+	auto entity = world.insertEntity("entity");
+
+	world.resetPerfCounters();
+
+	for (std::size_t i = 0; i < detail::perfSampleRate * 4; i++) ETCS_CHECK(entity.name() == "entity"); // a single lookup by id each
+
+	ETCS_CHECK(world.perfCounters()[static_cast<std::size_t>(PerfOperation::entityData)].calls == detail::perfSampleRate * 4);
+
+	eraseWorld(world);
+}
+
+#endif
+
+ETCS_TEST_MAIN()
@@ -0,0 +1,195 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/EntityQuery.h>
+#include <ETCS/Prefab.h>
+
+using namespace etcs;
+
+struct Position { 
+	float x = 0, y = 0; 
+};
+struct Targets { };
+struct Likes { };
+
+ETCS_TEST(childOfArchetypesReclaimed) {
+	auto world = insertWorld("relation_child_of_reclaimed");
+
+	auto before = world.memoryStats().archetypes.size();
+
+	vector_t<Entity> parents;
+	for (int i = 0; i < 16; i++) {
+		auto parent = world.insertEntity();
+		for (int j = 0; j < 4; j++) parent.insertChild("child" + std::to_string(j)).insertComponent<Position>();
+		parents.push_back(parent);
+	}
+
+	ETCS_CHECK(world.memoryStats().archetypes.size() > before + 16);
+
+	for (auto& parent : parents) parent.destroyRecursive();
+	world.nextFrame(); // the emptied archetypes are only destroyed at the next frame
+
+	auto stats = world.memoryStats();
+	for (const auto& archetype : stats.archetypes) ETCS_CHECK(archetype.relations == 0 || archetype.entities > 0);
+	ETCS_CHECK(stats.archetypes.size() <= before + 2); // only the archetypes without relations remain
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(queryOutlivesErasedParent) { // archetypes of erased targets stay alive until the next frame, after which the query collects its archetypes again
+	auto world = insertWorld("relation_query_outlives_parent");
+
+	world.insertEntity().insertComponent<Position>(Position { 1, 0 });
+
+	auto parent = world.insertEntity();
+	for (int i = 0; i < 4; i++) parent.insertChild("child" + std::to_string(i)).insertComponent<Position>(Position { 2, 0 });
+
+	auto query = world.query<const Position>();
+	auto children = world.queryRelated<ChildOf, const Position>(parent);
+
+	auto sum = [](auto& query) {
+		float sum = 0;
+		for (auto [position] : query) sum += position.x;
+		return sum;
+	};
+
+	ETCS_CHECK(sum(query) == 9);
+	ETCS_CHECK(sum(children) == 8);
+
+	parent.destroyRecursive();
+
+	ETCS_CHECK(sum(query) == 1); // the archetype of the children is empty, but still alive
+	ETCS_CHECK(sum(children) == 0);
+
+	world.nextFrame();
+
+	ETCS_CHECK(sum(query) == 1);
+	ETCS_CHECK(sum(children) == 0);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(childrenRetargetedOnErase) {
+	auto world = insertWorld("relation_child_of_retargeted");
+
+	auto root = world.insertEntity();
+	auto parent = root.insertChild("parent");
+	auto child = parent.insertChild("child");
+	child.insertComponent<Position>();
+
+	auto before = world.memoryStats().archetypes.size();
+	parent.destroy();
+
+	ETCS_CHECK(child.relationTarget<ChildOf>().id() == root.id());
+
+	std::size_t count = 0;
+	for (auto [position] : world.queryRelated<ChildOf, Position>(root)) {
+		(void)position;
+		count++;
+	}
+	ETCS_CHECK(count == 1);
+
+	world.nextFrame();
+	ETCS_CHECK(world.memoryStats().archetypes.size() == before - 1); // both archetypes of the parent were destroyed, the child moved into a new one
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(relationsDroppedWithTarget) {
+	auto world = insertWorld("relation_dropped");
+
+	auto target = world.insertEntity();
+	auto other = world.insertEntity();
+
+	vector_t<Entity> sources;
+	for (int i = 0; i < 8; i++) {
+		auto source = world.insertEntity();
+		source.insertComponent<Position>(Position { float(i), 0 });
+		source.insertRelation<Targets>(target);
+		if (i % 2) source.insertRelation<Likes>(other);
+		else source.insertRelation<Likes>(target); // two relations to the same target in one archetype
+		sources.push_back(source);
+	}
+
+	target.destroy();
+
+	for (auto& source : sources) {
+		ETCS_CHECK(!source.containsRelation<Targets>());
+		ETCS_CHECK(source.contains<Position>());
+
+		auto odd = int(source.component<Position>().get().x) % 2 == 1; // only kept the relation to the other target
+		ETCS_CHECK(source.containsRelation<Likes>() == odd);
+		if (odd) ETCS_CHECK(source.relationTarget<Likes>().id() == other.id());
+	}
+
+	world.nextFrame();
+	for (const auto& archetype : world.memoryStats().archetypes) ETCS_CHECK(archetype.relations == 0 || archetype.entities > 0);
+
+	auto reused = world.insertEntity(); // may reuse the id of the erased target
+	std::size_t related = 0;
+	for (auto [position] : world.queryRelated<Targets, Position>(reused)) {
+		(void)position;
+		related++;
+	}
+	ETCS_CHECK(related == 0);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(queryRelatedOnlyVisitsTarget) {
+	auto world = insertWorld("relation_query_related");
+
+	auto first = world.insertEntity();
+	auto second = world.insertEntity();
+
+	for (int i = 0; i < 10; i++) {
+		auto entity = world.insertEntity();
+		entity.insertComponent<Position>();
+		entity.insertRelation<Targets>(i < 3 ? first : second);
+	}
+
+	std::size_t firstCount = 0, secondCount = 0;
+	for (auto [position] : world.queryRelated<Targets, const Position>(first)) {
+		(void)position;
+		firstCount++;
+	}
+	for (auto [position] : world.queryRelated<Targets, const Position>(second)) {
+		(void)position;
+		secondCount++;
+	}
+
+	ETCS_CHECK(firstCount == 3);
+	ETCS_CHECK(secondCount == 7);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(prefabChildrenGroupedByParent) {
+	auto world = insertWorld("relation_prefab_children");
+
+	Prefab prefab("root");
+	prefab.insertComponent<Position>(Position { 1, 2 });
+	prefab.insertChild("first").insertComponent<Position>(Position { 3, 4 });
+	prefab.insertChild("second").insertComponent<Position>(Position { 5, 6 });
+
+	auto roots = world.instantiate(prefab, 32);
+	ETCS_CHECK(roots.size() == 32);
+
+	for (const auto& root : roots) {
+		std::size_t children = 0;
+		float sum = 0;
+
+		for (auto [position] : world.queryRelated<ChildOf, const Position>(root)) {
+			sum += position.x;
+			children++;
+		}
+
+		ETCS_CHECK(children == 2);
+		ETCS_CHECK(sum == 8);
+		ETCS_CHECK(root.at("first").component<Position>().get().y == 4);
+	}
+
+	eraseWorld(world);
+}
+
+ETCS_TEST_MAIN()
@@ -0,0 +1,109 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/EntityQuery.h>
+#include <ETCS/Prefab.h>
+#include <ETCS/SpawnBuffer.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+using namespace etcs;
+
+struct Position {
+	float x = 0, y = 0;
+};
+
+namespace {
+
+vector_t<object_id> entityIds(World world) { // of all entities, sorted
+	vector_t<object_id> ids;
+	for (auto [entity] : world.query<Entity>()) ids.push_back(entity.id());
+
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+} // namespace
+
+ETCS_TEST(spawnFromWorkers) {
+	constexpr std::size_t workers = 4;
+	constexpr std::size_t plain = 300; // more than a block, so every buffer reserves a second one
+	constexpr std::size_t instances = 50;
+
+	auto world = insertWorld("spawn_buffer_workers");
+
+	Prefab prefab("root");
+	prefab.insertComponent<Position>(Position { 1, 0 });
+	prefab.insertChild("child").insertComponent<Position>(Position { 2, 0 });
+
+	vector_t<SpawnBuffer> buffers;
+	vector_t<vector_t<Entity>> spawned(workers);
+	for (std::size_t i = 0; i < workers; i++) buffers.emplace_back(world);
+
+	{
+		vector_t<std::thread> threads;
+		for (std::size_t i = 0; i < workers; i++) {
+			threads.emplace_back([&, i] {
+				for (std::size_t j = 0; j < plain; j++) {
+					spawned[i].push_back(buffers[i].spawn());
+					if (j < instances) spawned[i].push_back(buffers[i].spawn(prefab));
+				}
+			});
+		}
+
+		for (auto& thread : threads) thread.join();
+	}
+
+	for (auto& buffer : buffers) {
+		ETCS_CHECK(buffer.size() == plain + instances);
+		buffer.publish();
+		ETCS_CHECK(buffer.empty());
+	}
+
+	std::size_t roots = 0;
+	for (const auto& entities : spawned) {
+		for (const auto& entity : entities) {
+			if (!entity.contains<Position>()) continue;
+
+			ETCS_CHECK(entity.component<Position>().get().x == 1);
+			ETCS_CHECK(entity.at("child").component<Position>().get().x == 2);
+			roots++;
+		}
+	}
+	ETCS_CHECK(roots == workers * instances);
+
+	auto ids = entityIds(world);
+	ETCS_CHECK(ids.size() == workers * (plain + instances * 2));
+	ETCS_CHECK(std::adjacent_find(ids.begin(), ids.end()) == ids.end()); // no id was handed out twice
+
+	for (std::size_t i = 0; i < workers * SpawnBuffer::blockSize * 2; i++) static_cast<void>(world.insertEntity()); // fills the unused ids of the blocks first
+
+	ids = entityIds(world);
+	ETCS_CHECK(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+	ETCS_CHECK(ids.back() + 1 == ids.size()); // no id of a block was lost
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(destroyedWithoutPublish) {
+	auto world = insertWorld("spawn_buffer_discarded");
+
+	{
+		SpawnBuffer buffer(world);
+		for (std::size_t i = 0; i < 10; i++) static_cast<void>(buffer.spawn());
+
+		SpawnBuffer moved(std::move(buffer)); // only the buffer it was moved into returns the ids
+	}
+
+	for (std::size_t i = 0; i < SpawnBuffer::blockSize; i++) static_cast<void>(world.insertEntity());
+
+	auto ids = entityIds(world);
+	ETCS_CHECK(ids.size() == SpawnBuffer::blockSize);
+	ETCS_CHECK(ids.back() + 1 == ids.size()); // the discarded entities and the rest of the block were reused
+
+	eraseWorld(world);
+}
+
+ETCS_TEST_MAIN()
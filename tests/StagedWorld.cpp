@@ -0,0 +1,93 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/EntityQuery.h>
+#include <ETCS/StagedWorld.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace etcs;
+
+struct Position {
+	float x = 0, y = 0;
+};
+
+namespace {
+
+constexpr std::size_t stagedWorlds = 8;
+constexpr std::size_t entitiesPerWorld = 256;
+
+void stage(WorldHandoff& handoff, memory_resource* upstream, std::size_t index) {
+	StagedWorld staged("staged_world_" + std::to_string(index), upstream);
+
+	auto world = staged.world();
+	for (std::size_t i = 0; i < entitiesPerWorld; i++) {
+		auto entity = world.insertEntity("staged_entity_with_a_long_name_" + std::to_string(i));
+		entity.insertComponent<Position>(Position { static_cast<float>(index), 1 });
+		entity.insertChild("child").insertComponent<Position>();
+	}
+
+	handoff.push(std::move(staged));
+}
+
+std::size_t count(World world) {
+	std::size_t n = 0;
+	for (auto [position] : world.query<const Position>()) n += static_cast<std::size_t>(position.y);
+	return n;
+}
+
+} // namespace
+
+ETCS_TEST(mergeIntoFreesStagedWorlds) {
+	static test::CountingResource upstream; // outlives the staged worlds if a check fails before they are merged
+
+	auto target = insertWorld("staged_merge_target");
+	WorldHandoff handoff;
+
+	for (std::size_t frame = 0; frame < 4; frame++) { // the memory of the merged worlds doesn't pile up over the frames
+		vector_t<std::thread> workers;
+		for (std::size_t i = 0; i < stagedWorlds; i++) workers.emplace_back(stage, std::ref(handoff), &upstream, frame * stagedWorlds + i);
+		for (auto& worker : workers) worker.join();
+
+		ETCS_CHECK(upstream.bytes() > 0);
+		ETCS_CHECK(handoff.mergeInto(target) == stagedWorlds);
+
+		ETCS_CHECK(handoff.empty());
+		ETCS_CHECK(upstream.bytes() == 0);
+		ETCS_CHECK(count(target) == (frame + 1) * stagedWorlds * entitiesPerWorld);
+	}
+
+	eraseWorld(target);
+}
+
+ETCS_TEST(mergeRelinksColumnsOfTarget) { // the components stay where they are, since the staged world allocated them from the memory of the target
+	auto target = insertWorld("staged_relink_target");
+
+	vector_t<const Position*> staged;
+	{
+		StagedWorld world(target, "staged_relink");
+		for (std::size_t i = 0; i < entitiesPerWorld; i++) world.world().insertEntity().insertComponent<Position>(Position { static_cast<float>(i), 1 });
+
+		for (auto [position] : world.world().query<const Position>()) staged.push_back(&position);
+
+		target.merge(world.world());
+	}
+
+	vector_t<const Position*> merged;
+	float sum = 0;
+	for (auto [position] : target.query<const Position>()) {
+		merged.push_back(&position);
+		sum += position.x;
+	}
+
+	ETCS_CHECK(merged == staged);
+	ETCS_CHECK(sum == static_cast<float>(entitiesPerWorld * (entitiesPerWorld - 1) / 2));
+
+	eraseWorld(target);
+}
+
+ETCS_TEST_MAIN()
@@ -0,0 +1,119 @@
+/*************************
+ * @file Test.h
+ * @author Zhile Zhu (zhuzhile08@gmail.com)
+ *
+ * @brief Minimal test harness, every test file is its own executable registered with ctest
+ *
+ * @date 2024-10-20
+ *
+ * @copyright Copyright (c) 2024
+ *************************/
+
+#pragma once
+
+#include <ETCS/World.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace etcs {
+
+namespace test {
+
+struct Failure {
+	const char* expression;
+	const char* file;
+	int line;
+};
+
+// upstream of worlds, which counts the bytes they still hold, so a test can check that erased worlds left nothing behind
+class CountingResource : public std::pmr::memory_resource {
+public:
+	[[nodiscard]] std::size_t bytes() const noexcept {
+		return m_bytes;
+	}
+
+private:
+	std::atomic<std::size_t> m_bytes = 0; // worlds using it may be populated on different threads
+
+	void* do_allocate(std::size_t size, std::size_t alignment) override {
+		m_bytes += size;
+		return std::pmr::new_delete_resource()->allocate(size, alignment);
+	}
+	void do_deallocate(void* p, std::size_t size, std::size_t alignment) override {
+		m_bytes -= size;
+		std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
+
+using test_function = void(*)();
+
+inline std::vector<std::pair<const char*, test_function>>& tests() {
+	static std::vector<std::pair<const char*, test_function>> tests;
+	return tests;
+}
+
+struct Registration {
+	Registration(const char* name, test_function function) {
+		tests().emplace_back(name, function);
+	}
+};
+
+// runs all tests of the executable, or only the one named by the first argument
+inline int run(int argc, char** argv) {
+	int failed = 0;
+
+	init();
+
+	for (const auto& [name, function] : tests()) {
+		if (argc > 1 && std::string_view(argv[1]) != name) continue;
+
+		try {
+			function();
+			std::printf("passed %s\n", name);
+		} catch (const Failure& failure) {
+			std::printf("FAILED %s: %s at %s:%d\n", name, failure.expression, failure.file, failure.line);
+			failed++;
+		} catch (const std::exception& exception) {
+			std::printf("FAILED %s: unexpected exception: %s\n", name, exception.what());
+			failed++;
+		}
+	}
+
+	quit();
+
+	return failed == 0 ? 0 : 1;
+}
+
+} // namespace test
+
+} // namespace etcs
+
+#define ETCS_TEST(name) \
+	static void name(); \
+	static const etcs::test::Registration name##Registration(#name, name); \
+	static void name()
+
+#define ETCS_CHECK(expression) \
+	do { if (!(expression)) throw etcs::test::Failure { #expression, __FILE__, __LINE__ }; } while (false)
+
+#define ETCS_CHECK_THROWS(expression, exception) \
+	do { \
+		bool thrown = false; \
+		try { expression; } catch (const exception&) { thrown = true; } \
+		if (!thrown) throw etcs::test::Failure { #expression " throws " #exception, __FILE__, __LINE__ }; \
+	} while (false)
+
+#define ETCS_TEST_MAIN() \
+	int main(int argc, char** argv) { \
+		return etcs::test::run(argc, argv); \
+	}
@@ -0,0 +1,110 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/WorldAccess.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace etcs;
+
+struct Position {
+	float x = 0, y = 0;
+};
+
+ETCS_TEST(forkWhileErasingSource) {
+	constexpr std::size_t iterations = 64;
+	constexpr std::size_t entities = 512;
+
+	std::size_t forked = 0, erasedFirst = 0;
+
+	for (std::size_t i = 0; i < iterations; i++) {
+		auto source = insertWorld("fork_erase_source_" + std::to_string(i));
+		for (std::size_t j = 0; j < entities; j++) source.insertEntity().insertComponent<Position>(Position { static_cast<float>(j), 0 });
+
+		std::atomic<bool> start = false;
+		std::optional<World> fork;
+
+		std::thread forker([&] {
+			while (!start.load()) { }
+
+			try {
+				fork = forkWorld(source, "fork_erase_fork_" + std::to_string(i));
+			} catch (const std::out_of_range&) { } // the source was erased before the copy started
+		});
+		std::thread eraser([&] {
+			while (!start.load()) { }
+			eraseWorld(source);
+		});
+
+		start = true;
+		forker.join();
+		eraser.join();
+
+		ETCS_CHECK(!source.alive());
+
+		if (fork) { // the copy was finished before the source was erased
+			ETCS_CHECK(fork->alive());
+			ETCS_CHECK(fork->memoryStats().entities.entities == entities);
+
+			eraseWorld(*fork);
+			forked++;
+		} else erasedFirst++;
+	}
+
+	ETCS_CHECK(forked + erasedFirst == iterations);
+}
+
+ETCS_TEST(worldsChangedWhileForking) { // the copy only pins its source, so other worlds can be inserted and erased meanwhile
+	auto source = insertWorld("fork_pinned_source");
+	for (std::size_t i = 0; i < 64; i++) source.insertEntity().insertComponent<Position>();
+
+	std::optional<World> fork;
+	std::thread forker, eraser;
+
+	{
+		WriteAccess write(source); // stalls the copy
+
+		forker = std::thread([&] {
+			fork = forkWorld(source, "fork_pinned_copy");
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		auto other = insertWorld("fork_pinned_other");
+		ETCS_CHECK(containsWorld("fork_pinned_other"));
+		eraseWorld(other);
+
+		eraser = std::thread([&] {
+			eraseWorld(source); // waits until the copy finished
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		ETCS_CHECK(!source.alive());
+		ETCS_CHECK(!fork);
+	}
+
+	forker.join();
+	eraser.join();
+
+	ETCS_CHECK(fork && fork->alive());
+	ETCS_CHECK(fork->memoryStats().entities.entities == 64);
+
+	eraseWorld(*fork);
+}
+
+ETCS_TEST(forkTakenName) {
+	auto source = insertWorld("fork_taken_source");
+	auto taken = insertWorld("fork_taken_name");
+
+	ETCS_CHECK_THROWS(forkWorld(source, "fork_taken_name"), std::logic_error);
+
+	eraseWorld(taken);
+	eraseWorld(source);
+}
+
+ETCS_TEST_MAIN()
@@ -0,0 +1,172 @@
+#include "Test.h"
+
+#include <ETCS/Entity.h>
+#include <ETCS/EntityQuery.h>
+#include <ETCS/WorldAccess.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace etcs;
+
+struct Position {
+	float x = 0, y = 0;
+};
+struct Velocity {
+	float x = 0, y = 0;
+};
+
+#ifdef ETCS_ENABLE_ACCESS_CHECKS
+
+ETCS_TEST(structuralChangeUnderReadAccess) {
+	auto world = insertWorld("access_structural_change");
+	auto entity = world.insertEntity();
+
+	{
+		ReadAccess read(world);
+		ETCS_CHECK_THROWS(world.insertEntity(), std::logic_error);
+		ETCS_CHECK_THROWS(entity.insertComponent<Position>(), std::logic_error);
+	}
+
+	entity.insertComponent<Position>(); // allowed again once the read access was released
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(writableQueryOfReadComponent) {
+	auto world = insertWorld("access_writable_query");
+	world.insertEntity().insertComponent<Position>();
+
+	{
+		ReadAccess read(world);
+		read.query<const Position>();
+
+		ETCS_CHECK_THROWS(world.query<Position>(), std::logic_error);
+		world.query<Velocity>(); // nobody reads it
+		world.query<const Position>();
+	}
+
+	world.query<Position>();
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(readAccessDuringStructuralChange) { // a read access and a structural change starting at the same time, at most one of them may succeed while the other runs
+	auto world = insertWorld("access_concurrent");
+	for (std::size_t i = 0; i < 64; i++) world.insertEntity().insertComponent<Position>();
+
+	constexpr std::size_t iterations = 2000;
+
+	std::atomic<bool> start = false;
+	std::size_t inserted = 0;
+
+	std::thread reader([&] {
+		while (!start.load()) { }
+
+		for (std::size_t i = 0; i < iterations; i++) {
+			try {
+				ReadAccess read(world);
+
+				float sum = 0;
+				for (auto [position] : read.query<const Position>()) sum += position.x;
+				static_cast<void>(sum);
+			} catch (const std::logic_error&) { } // a structural change was in progress
+		}
+	});
+	std::thread writer([&] {
+		while (!start.load()) { }
+
+		for (std::size_t i = 0; i < iterations; i++) {
+			try {
+				world.insertEntity();
+				inserted++;
+			} catch (const std::logic_error&) { } // the world was being read
+		}
+	});
+
+	start = true;
+	reader.join();
+	writer.join();
+
+	ETCS_CHECK(world.memoryStats().entities.entities == 64 + inserted);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST(forkDuringStructuralChange) { // the copy holds read access of the source, so a structural change either conflicts with it or the fork fails
+	auto world = insertWorld("access_fork_source");
+	for (std::size_t i = 0; i < 64; i++) world.insertEntity().insertComponent<Position>();
+
+	constexpr std::size_t iterations = 200;
+
+	std::atomic<bool> start = false;
+	std::atomic<std::size_t> inserted = 0;
+
+	std::thread forker([&] {
+		while (!start.load()) { }
+
+		for (std::size_t i = 0; i < iterations; i++) {
+			try {
+				auto before = inserted.load();
+				auto fork = forkWorld(world, "access_fork_" + std::to_string(i));
+				auto entities = fork.memoryStats().entities.entities;
+
+				ETCS_CHECK(entities >= 64 + before && entities <= 64 + inserted.load() + 1); // the last insertion may not be counted yet
+
+				eraseWorld(fork);
+			} catch (const std::logic_error&) { } // a structural change was in progress
+		}
+	});
+	std::thread writer([&] {
+		while (!start.load()) { }
+
+		for (std::size_t i = 0; i < iterations; i++) {
+			try {
+				world.insertEntity();
+				inserted++;
+			} catch (const std::logic_error&) { } // the world was being forked
+		}
+	});
+
+	start = true;
+	forker.join();
+	writer.join();
+
+	ETCS_CHECK(world.memoryStats().entities.entities == 64 + inserted);
+
+	eraseWorld(world);
+}
+
+#endif
+
+ETCS_TEST(forkWaitsForWriteAccess) {
+	auto world = insertWorld("access_fork_write");
+	for (std::size_t i = 0; i < 64; i++) world.insertEntity().insertComponent<Position>();
+
+	std::size_t entities = 0;
+	std::thread forker;
+
+	{
+		WriteAccess write(world);
+
+		forker = std::thread([&] {
+			auto fork = forkWorld(world, "access_fork_write_copy");
+			entities = fork.memoryStats().entities.entities;
+			eraseWorld(fork);
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		world.insertEntity(); // the fork only starts copying once the write access was released
+	}
+
+	forker.join();
+	ETCS_CHECK(entities == 65);
+
+	eraseWorld(world);
+}
+
+ETCS_TEST_MAIN()